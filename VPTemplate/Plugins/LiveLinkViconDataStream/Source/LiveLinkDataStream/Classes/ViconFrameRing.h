@@ -0,0 +1,98 @@
+// Copyright (c) 2021 Vicon Motion Systems Ltd. All Rights Reserved.
+
+#pragma once
+
+// =========================================================================
+// Lock-free single producer / single consumer ring of preallocated slots.
+//
+// Slots are constructed once and reused, so anything they own (arrays etc.)
+// keeps its allocation between frames. The producer never blocks: if the
+// ring is full BeginWrite returns nullptr and the overflow is counted.
+// =========================================================================
+
+#include "CoreMinimal.h"
+
+#include <atomic>
+
+template< typename SlotType >
+class TViconFrameRing
+{
+public:
+  // Capacity is rounded up to a power of two
+  explicit TViconFrameRing( uint32 i_Capacity )
+  : m_Mask( FMath::RoundUpToPowerOfTwo( FMath::Max( i_Capacity, 2u ) ) - 1 )
+  , m_Head( 0 )
+  , m_Tail( 0 )
+  , m_OverflowCount( 0 )
+  , m_HighWaterMark( 0 )
+  {
+    m_Slots.SetNum( m_Mask + 1 );
+  }
+
+  TViconFrameRing( const TViconFrameRing& ) = delete;
+  TViconFrameRing& operator=( const TViconFrameRing& ) = delete;
+
+  // Producer: get the next free slot, or nullptr if the consumer has fallen a full ring behind
+  SlotType* BeginWrite()
+  {
+    const uint32 Head = m_Head.load( std::memory_order_relaxed );
+    const uint32 Tail = m_Tail.load( std::memory_order_acquire );
+    if( Head - Tail > m_Mask )
+    {
+      m_OverflowCount.fetch_add( 1, std::memory_order_relaxed );
+      return nullptr;
+    }
+    return &m_Slots[ Head & m_Mask ];
+  }
+
+  // Producer: publish the slot returned by BeginWrite
+  void CommitWrite()
+  {
+    const uint32 Head = m_Head.load( std::memory_order_relaxed ) + 1;
+    m_Head.store( Head, std::memory_order_release );
+
+    const uint32 Used = Head - m_Tail.load( std::memory_order_relaxed );
+    if( Used > m_HighWaterMark.load( std::memory_order_relaxed ) )
+    {
+      m_HighWaterMark.store( Used, std::memory_order_relaxed );
+    }
+  }
+
+  // Consumer: get the oldest published slot, or nullptr if the ring is empty
+  SlotType* BeginRead()
+  {
+    const uint32 Tail = m_Tail.load( std::memory_order_relaxed );
+    if( Tail == m_Head.load( std::memory_order_acquire ) )
+    {
+      return nullptr;
+    }
+    return &m_Slots[ Tail & m_Mask ];
+  }
+
+  // Consumer: hand the slot returned by BeginRead back to the producer
+  void EndRead()
+  {
+    m_Tail.store( m_Tail.load( std::memory_order_relaxed ) + 1, std::memory_order_release );
+  }
+
+  // Number of published slots not yet released by the consumer
+  uint32 Num() const
+  {
+    return m_Head.load( std::memory_order_acquire ) - m_Tail.load( std::memory_order_acquire );
+  }
+
+  uint32 Capacity() const { return m_Mask + 1; }
+  uint64 GetOverflowCount() const { return m_OverflowCount.load( std::memory_order_relaxed ); }
+  uint32 GetHighWaterMark() const { return m_HighWaterMark.load( std::memory_order_relaxed ); }
+
+private:
+  TArray< SlotType > m_Slots;
+  const uint32 m_Mask;
+
+  // Head is only written by the producer, tail only by the consumer. Keep them on separate cache lines.
+  alignas( PLATFORM_CACHE_LINE_SIZE ) std::atomic< uint32 > m_Head;
+  alignas( PLATFORM_CACHE_LINE_SIZE ) std::atomic< uint32 > m_Tail;
+
+  alignas( PLATFORM_CACHE_LINE_SIZE ) std::atomic< uint64 > m_OverflowCount;
+  std::atomic< uint32 > m_HighWaterMark;
+};
@@ -0,0 +1,179 @@
+// Copyright (c) 2021 Vicon Motion Systems Ltd. All Rights Reserved.
+
+#pragma once
+
+// =========================================================================
+// Frame sequence tracking for a Vicon Data Stream connection.
+//
+// Follows the stream frame number and the hardware (camera) frame number
+// of each frame the reader receives and classifies discontinuities:
+// - Gap: stream frame numbers were skipped, i.e. frames were lost between
+//   the server and us (network, or the reader not keeping up).
+// - Hardware gap: the stream frame number is contiguous but the hardware
+//   frame number skipped, i.e. the server dropped camera frames.
+// - Duplicate: a frame was delivered again, or a new stream frame carried
+//   a camera frame we have already seen.
+// - Reorder: the stream frame number went backwards.
+//
+// Written by the acquisition thread; counts may be read from any thread.
+// The window is rolled by whoever reads the windowed counts, so it keeps
+// moving when frames stop arriving.
+// =========================================================================
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/ScopeLock.h"
+
+#include <atomic>
+
+class FViconFrameSequenceCounts
+{
+public:
+  uint64 Gaps = 0;
+  // Total number of stream frames missing across all gaps
+  uint64 FramesMissed = 0;
+  uint64 HardwareGaps = 0;
+  uint64 Duplicates = 0;
+  uint64 Reorders = 0;
+};
+
+class FViconFrameSequenceTracker
+{
+public:
+  // Length of the window used for the windowed counts
+  static constexpr double WindowSeconds = 10.0;
+  // Frame numbers further back than this are taken as the server restarting rather than a reorder
+  static constexpr int32 MaxReorderDistance = 1000;
+
+  // Forget the previous frame, e.g. after reconnecting. Counts are kept.
+  void ResetSequence()
+  {
+    m_bHasLastFrame = false;
+  }
+
+  // Record a frame. i_bCountRepeats should be false when repeated frame numbers are expected,
+  // e.g. when polling GetFrame faster than the server frame rate.
+  // Returns false if the frame is not new, i.e. it is a repeat, duplicate or reorder.
+  bool AddFrame( uint32 i_FrameNumber, uint32 i_HardwareFrameNumber, bool i_bCountRepeats )
+  {
+    if( !m_bHasLastFrame )
+    {
+      m_bHasLastFrame = true;
+      m_LastFrameNumber = i_FrameNumber;
+      m_LastHardwareFrameNumber = i_HardwareFrameNumber;
+      return true;
+    }
+
+    // Signed differences, so wrap around is handled
+    const int32 Delta = static_cast< int32 >( i_FrameNumber - m_LastFrameNumber );
+    const int32 HardwareDelta = static_cast< int32 >( i_HardwareFrameNumber - m_LastHardwareFrameNumber );
+
+    if( Delta == 0 )
+    {
+      if( i_bCountRepeats )
+      {
+        ++m_Duplicates;
+      }
+      return false;
+    }
+    if( Delta < 0 && Delta >= -MaxReorderDistance )
+    {
+      ++m_Reorders;
+      return false;
+    }
+    if( Delta < 0 )
+    {
+      // The server restarted, resynchronise
+      m_LastFrameNumber = i_FrameNumber;
+      m_LastHardwareFrameNumber = i_HardwareFrameNumber;
+      return true;
+    }
+
+    m_LastFrameNumber = i_FrameNumber;
+    m_LastHardwareFrameNumber = i_HardwareFrameNumber;
+
+    if( Delta > 1 )
+    {
+      ++m_Gaps;
+      m_FramesMissed += Delta - 1;
+    }
+    if( HardwareDelta == 0 )
+    {
+      ++m_Duplicates;
+    }
+    else if( HardwareDelta > Delta )
+    {
+      ++m_HardwareGaps;
+    }
+    return true;
+  }
+
+  FViconFrameSequenceCounts GetTotalCounts() const
+  {
+    FViconFrameSequenceCounts Counts;
+    Counts.Gaps = m_Gaps;
+    Counts.FramesMissed = m_FramesMissed;
+    Counts.HardwareGaps = m_HardwareGaps;
+    Counts.Duplicates = m_Duplicates;
+    Counts.Reorders = m_Reorders;
+    return Counts;
+  }
+
+  // Counts over the last complete window. A window lasts until it is read at least WindowSeconds after it
+  // started, so the counts are scaled from the time it actually covered to WindowSeconds.
+  FViconFrameSequenceCounts GetWindowCounts() const
+  {
+    FScopeLock Lock( &m_WindowMutex );
+    RollWindow();
+    return m_WindowCounts;
+  }
+
+private:
+  // Called with m_WindowMutex held
+  void RollWindow() const
+  {
+    const double Now = FPlatformTime::Seconds();
+    if( m_WindowStart == 0.0 )
+    {
+      m_WindowStart = Now;
+      m_WindowStartCounts = GetTotalCounts();
+      return;
+    }
+    const double Elapsed = Now - m_WindowStart;
+    if( Elapsed < WindowSeconds )
+    {
+      return;
+    }
+
+    const FViconFrameSequenceCounts Total = GetTotalCounts();
+    const double Scale = WindowSeconds / Elapsed;
+    auto ScaleCount = [ Scale ]( uint64 i_Count, uint64 i_StartCount )
+    {
+      return static_cast< uint64 >( FMath::RoundToDouble( ( i_Count - i_StartCount ) * Scale ) );
+    };
+    m_WindowCounts.Gaps = ScaleCount( Total.Gaps, m_WindowStartCounts.Gaps );
+    m_WindowCounts.FramesMissed = ScaleCount( Total.FramesMissed, m_WindowStartCounts.FramesMissed );
+    m_WindowCounts.HardwareGaps = ScaleCount( Total.HardwareGaps, m_WindowStartCounts.HardwareGaps );
+    m_WindowCounts.Duplicates = ScaleCount( Total.Duplicates, m_WindowStartCounts.Duplicates );
+    m_WindowCounts.Reorders = ScaleCount( Total.Reorders, m_WindowStartCounts.Reorders );
+    m_WindowStartCounts = Total;
+    m_WindowStart = Now;
+  }
+
+  bool m_bHasLastFrame = false;
+  uint32 m_LastFrameNumber = 0;
+  uint32 m_LastHardwareFrameNumber = 0;
+
+  std::atomic< uint64 > m_Gaps{ 0 };
+  std::atomic< uint64 > m_FramesMissed{ 0 };
+  std::atomic< uint64 > m_HardwareGaps{ 0 };
+  std::atomic< uint64 > m_Duplicates{ 0 };
+  std::atomic< uint64 > m_Reorders{ 0 };
+
+  // Window state, rolled by the readers of the windowed counts
+  mutable FCriticalSection m_WindowMutex;
+  mutable double m_WindowStart = 0.0;
+  mutable FViconFrameSequenceCounts m_WindowStartCounts;
+  mutable FViconFrameSequenceCounts m_WindowCounts;
+};
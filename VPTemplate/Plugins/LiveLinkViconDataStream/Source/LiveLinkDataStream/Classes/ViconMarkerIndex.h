@@ -0,0 +1,84 @@
+// Copyright (c) 2021 Vicon Motion Systems Ltd. All Rights Reserved.
+
+#pragma once
+
+// =========================================================================
+// Spatial index over the labeled and unlabeled markers of a frame.
+//
+// The conversion thread builds one index per frame from the point clouds it
+// pushes, and publishes it as an immutable snapshot. Queries then cost the
+// markers near the query rather than every marker in the frame, however
+// many actors make them.
+//
+// The index is a uniform grid over the bounds of the markers, with about one
+// marker per cell. Markers are sorted by cell, so each cell is a contiguous
+// range and the grid is built in time linear in the marker count.
+//
+// Positions are in the LiveLink space of the marker subjects, in cm.
+// =========================================================================
+
+#include "CoreMinimal.h"
+
+class FViconMarkerIndex
+{
+public:
+  class FMarker
+  {
+  public:
+    FVector3f Position = FVector3f::ZeroVector;
+    // Index of the point in its subject's point cloud
+    int32 PointIndex = INDEX_NONE;
+    // Persistent id of the marker, INDEX_NONE if the subject's markers are not tracked
+    int32 Id = INDEX_NONE;
+    // Index of the subject in GetSubjectNames()
+    int32 Subject = INDEX_NONE;
+  };
+
+  // Builder: start a new frame, add the valid points of each marker subject, then build the grid
+  void Reset( uint32 i_FrameNumber );
+  void AddSubject( FName i_SubjectName, TArrayView< const FVector3f > i_Points, TArrayView< const int32 > i_Ids );
+  void Build();
+
+  // Nearest marker to i_rLocation no further than i_MaxDistance away. Returns its index, or INDEX_NONE.
+  int32 FindNearest( const FVector3f& i_rLocation, float i_MaxDistance ) const;
+  // Append the indices of the markers within i_Radius of i_rLocation, or inside i_rBox, to io_rMarkers
+  void FindInRadius( const FVector3f& i_rLocation, float i_Radius, TArray< int32 >& io_rMarkers ) const;
+  void FindInBox( const FBox3f& i_rBox, TArray< int32 >& io_rMarkers ) const;
+
+  const FMarker& GetMarker( int32 i_Index ) const { return m_Markers[ i_Index ]; }
+  int32 NumMarkers() const { return m_Markers.Num(); }
+  const TArray< FName >& GetSubjectNames() const { return m_SubjectNames; }
+  uint32 GetFrameNumber() const { return m_FrameNumber; }
+
+private:
+  FORCEINLINE FIntVector CellOf( const FVector3f& i_rPosition ) const;
+  FORCEINLINE int32 CellIndex( int32 i_X, int32 i_Y, int32 i_Z ) const { return ( i_Z * m_Dimensions.Y + i_Y ) * m_Dimensions.X + i_X; }
+  // Cells overlapping a box, clamped to the grid. Returns false if the box misses the grid.
+  bool CellRange( const FVector3f& i_rMin, const FVector3f& i_rMax, FIntVector& o_rMinCell, FIntVector& o_rMaxCell ) const;
+
+  uint32 m_FrameNumber = 0;
+  TArray< FName > m_SubjectNames;
+  // Sorted by cell once built
+  TArray< FMarker > m_Markers;
+  // First marker of each cell, followed by the marker count
+  TArray< int32 > m_CellStarts;
+  FVector3f m_Origin = FVector3f::ZeroVector;
+  float m_CellSize = 1.0f;
+  float m_InvCellSize = 1.0f;
+  FIntVector m_Dimensions = FIntVector::ZeroValue;
+
+  // Scratch space, kept between builds to avoid allocating
+  TArray< FMarker > m_Unsorted;
+  TArray< int32 > m_MarkerCells;
+};
+
+using FViconMarkerIndexPtr = TSharedPtr< const FViconMarkerIndex, ESPMode::ThreadSafe >;
+
+// The latest index of every reader, for queries from the game thread
+class FViconMarkerIndexRegistry
+{
+public:
+  // Replace the index published by i_pPublisher. A null index withdraws it.
+  static void Publish( const void* i_pPublisher, FViconMarkerIndexPtr i_Index );
+  static void GetPublished( TArray< FViconMarkerIndexPtr >& o_rIndices );
+};
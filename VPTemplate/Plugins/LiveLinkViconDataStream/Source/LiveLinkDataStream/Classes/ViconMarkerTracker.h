@@ -0,0 +1,63 @@
+// Copyright (c) 2021 Vicon Motion Systems Ltd. All Rights Reserved.
+
+#pragma once
+
+// =========================================================================
+// Frame to frame identity of unlabeled markers.
+//
+// The SDK hands out unlabeled markers in arbitrary order every frame. The
+// tracker gives each marker a persistent id by associating it with the
+// nearest track, predicted at constant velocity, within a gate distance.
+// Tracks are bucketed in a spatial hash with cells as wide as the gate, so
+// each marker only looks at the tracks in its own and the neighbouring
+// cells, and a frame is tracked in time linear in the marker count.
+//
+// When two markers claim the same track, the nearer one continues it and
+// the other starts a new one. A track which is not matched coasts for a few
+// frames, so a marker which drops out briefly keeps its id.
+//
+// Only the conversion thread uses a tracker.
+// =========================================================================
+
+#include "CoreMinimal.h"
+
+class FViconMarkerTracker
+{
+public:
+  // Assign an id to each of i_Points, in o_Ids, given the points of the previous frames.
+  // Ids are never reused until the tracker is reset.
+  void Track( TArrayView< const FVector3f > i_Points, float i_GateDistance, TArrayView< int32 > o_Ids );
+
+  // Forget all tracks, e.g. when tracking is disabled
+  void Reset();
+
+  // Tracks being followed, including coasting ones
+  int32 NumTracks() const { return m_Tracks.Num(); }
+
+private:
+  class FTrack
+  {
+  public:
+    // Last matched position
+    FVector3f Position = FVector3f::ZeroVector;
+    // Displacement per frame
+    FVector3f Velocity = FVector3f::ZeroVector;
+    int32 Id = INDEX_NONE;
+    // Frames in a row the track has not been matched
+    int32 MissedFrames = 0;
+  };
+
+  TArray< FTrack > m_Tracks;
+  TArray< FTrack > m_NextTracks;
+  int32 m_NextId = 0;
+
+  // Scratch space, kept between frames to avoid allocating
+  // First track in each cell of the spatial hash, and the next track in the same cell
+  TMap< FIntVector, int32 > m_CellHeads;
+  TArray< int32 > m_NextInCell;
+  TArray< FVector3f > m_Predicted;
+  // Nearest track of each point within the gate, and the nearest of those points for each track
+  TArray< int32 > m_PointTrack;
+  TArray< float > m_PointDistanceSquared;
+  TArray< int32 > m_TrackPoint;
+};
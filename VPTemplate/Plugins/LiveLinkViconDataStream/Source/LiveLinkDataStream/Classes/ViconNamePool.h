@@ -0,0 +1,76 @@
+// Copyright (c) 2021 Vicon Motion Systems Ltd. All Rights Reserved.
+
+#pragma once
+
+// =========================================================================
+// Plugin wide pool of the subject, segment, marker and camera names seen
+// from any Vicon Data Stream connection.
+//
+// Each name is interned once, straight from the UTF-8 string the SDK hands
+// out, and is then referred to by a 32-bit id. The caches of every reader
+// are keyed by id, so comparing names is an integer compare, and the UTF-8
+// and FString forms of a name are held in one place for all sources.
+//
+// Names are never removed; ids stay valid for the lifetime of the module.
+// Interning takes a lock and may be called from any thread. Looking up the
+// string of an id does not lock; the id must have come from Intern, on this
+// thread or handed over from the interning thread.
+// =========================================================================
+
+#include "CoreMinimal.h"
+#include "Misc/ScopeRWLock.h"
+
+#include <atomic>
+#include <string>
+
+using FViconNameId = uint32;
+
+class FViconNamePool
+{
+public:
+  static FViconNamePool& Get();
+
+  ~FViconNamePool();
+
+  FViconNameId Intern( const char* i_pUtf8, int32 i_Length );
+  FViconNameId Intern( const std::string& i_rUtf8 ) { return Intern( i_rUtf8.data(), static_cast< int32 >( i_rUtf8.size() ) ); }
+  FViconNameId Intern( const FString& i_rName );
+
+  const std::string& GetUtf8( FViconNameId i_Id ) const { return GetEntry( i_Id ).Utf8; }
+  const FString& GetString( FViconNameId i_Id ) const { return GetEntry( i_Id ).Name; }
+
+  // Number of names interned so far
+  int32 Num() const { return m_NumEntries.load( std::memory_order_acquire ); }
+
+private:
+  FViconNamePool() = default;
+
+  class FEntry
+  {
+  public:
+    std::string Utf8;
+    FString Name;
+    uint64 Hash = 0;
+    // Next entry in the same hash bucket, or INDEX_NONE
+    int32 NextInBucket = INDEX_NONE;
+  };
+
+  // Entries live in fixed size chunks, so they never move once created and can be read without the lock
+  static constexpr int32 ChunkSize = 1024;
+  static constexpr int32 MaxChunks = 4096;
+
+  const FEntry& GetEntry( FViconNameId i_Id ) const
+  {
+    checkSlow( static_cast< int32 >( i_Id ) < Num() );
+    return m_Chunks[ i_Id / ChunkSize ][ i_Id % ChunkSize ];
+  }
+
+  // Id of the name, or INDEX_NONE. Must hold the lock.
+  int32 Find( const char* i_pUtf8, int32 i_Length, uint64 i_Hash ) const;
+
+  mutable FRWLock m_Lock;
+  // First entry of each hash bucket, by hash
+  TMap< uint64, int32 > m_Buckets;
+  FEntry* m_Chunks[ MaxChunks ] = {};
+  std::atomic< int32 > m_NumEntries{ 0 };
+};
@@ -0,0 +1,83 @@
+// Copyright (c) 2021 Vicon Motion Systems Ltd. All Rights Reserved.
+
+#pragma once
+
+// =========================================================================
+// Registry of the subject and camera names of a Vicon Data Stream connection.
+//
+// Each name is interned in FViconNamePool, and given the FName LiveLink
+// takes, once, when it is first seen, so the per-frame paths never convert
+// names. Entries are immutable and shared, so raw frames can hold on to
+// them after the registry has forgotten the name.
+//
+// Only the acquisition thread adds and removes names; entries may be read
+// from any thread.
+// =========================================================================
+
+#include "CoreMinimal.h"
+#include "ViconNamePool.h"
+
+#include <string>
+
+class FViconName
+{
+public:
+  FViconNameId Id = 0;
+  // Name of the LiveLink subject, including the system's subject prefix
+  FName LiveLinkName;
+  // Name of the LiveLink subject carrying the component space poses of a skeleton
+  FName ComponentSpaceName;
+
+  // Name in the SDK
+  const FString& Name() const { return FViconNamePool::Get().GetString( Id ); }
+  const std::string& Utf8() const { return FViconNamePool::Get().GetUtf8( Id ); }
+};
+
+using FViconNamePtr = TSharedPtr< const FViconName, ESPMode::ThreadSafe >;
+
+class FViconNameRegistry
+{
+public:
+  explicit FViconNameRegistry( const FString& i_rSubjectPrefix )
+  : m_SubjectPrefix( i_rSubjectPrefix )
+  {
+  }
+
+  FViconNamePtr FindOrAdd( FViconNameId i_Id )
+  {
+    if( const FViconNamePtr* pName = m_Names.Find( i_Id ) )
+    {
+      return *pName;
+    }
+
+    const FString& rName = FViconNamePool::Get().GetString( i_Id );
+    TSharedRef< FViconName, ESPMode::ThreadSafe > Name = MakeShared< FViconName, ESPMode::ThreadSafe >();
+    Name->Id = i_Id;
+    Name->LiveLinkName = FName( *( m_SubjectPrefix + rName ) );
+    Name->ComponentSpaceName = FName( *( m_SubjectPrefix + rName + TEXT( "_ComponentSpace" ) ) );
+    m_Names.Add( i_Id, Name );
+    return Name;
+  }
+
+  FViconNamePtr Find( FViconNameId i_Id ) const
+  {
+    const FViconNamePtr* pName = m_Names.Find( i_Id );
+    return pName ? *pName : FViconNamePtr();
+  }
+
+  void Remove( FViconNameId i_Id )
+  {
+    m_Names.Remove( i_Id );
+  }
+
+  void Empty()
+  {
+    m_Names.Empty();
+  }
+
+  int32 Num() const { return m_Names.Num(); }
+
+private:
+  FString m_SubjectPrefix;
+  TMap< FViconNameId, FViconNamePtr > m_Names;
+};
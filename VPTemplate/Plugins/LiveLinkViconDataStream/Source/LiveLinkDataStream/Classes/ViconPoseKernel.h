@@ -0,0 +1,72 @@
+// Copyright (c) 2021 Vicon Motion Systems Ltd. All Rights Reserved.
+
+#pragma once
+
+// =========================================================================
+// Batch conversion of raw segment poses to Unreal local transforms.
+//
+// Converts all segments of a subject in one pass: handedness flip, mm to cm,
+// removal of the hierarchy scale from the translation, the static scale and
+// the Y up axis mapping of the root. Each segment's translation, rotation and
+// scale are processed as one vector register each, and the result is written
+// straight into the output transforms.
+//
+// The converters returned by Select* are specialised at compile time for
+// rigid bodies or skeletons, the scaling option and the server axis mapping,
+// so their inner loops only branch on occlusion; they are selected once per
+// connection or frame rather than tested per segment or marker.
+//
+// Markers have no rotation, so their whole conversion is one 3x3 matrix,
+// worked out once per axis mapping. ConvertMarkerBatch applies it to the
+// flattened translations of a whole frame, a marker per vector register.
+//
+// LocalToComponentSpace composes converted local poses down the hierarchy,
+// in an order worked out once per schema by SortBonesParentFirst.
+//
+// Does not touch the SDK, so it is safe to call from any thread.
+// =========================================================================
+
+#include "CoreMinimal.h"
+#include "ViconRawFrame.h"
+
+class FViconPoseKernel
+{
+public:
+  // Rotation applied to the root when the server uses Y up axis mapping
+  static const FQuat YUpRotation;
+
+  // Convert i_Segments into the first i_Segments.Num() elements of o_Poses.
+  // i_pHierarchyScales holds one scale per segment to divide the translation by, used if the converter was selected
+  // for scaling. Rigid body converters only convert the first segment, whose hierarchy scale is always one, so may
+  // be given nullptr.
+  // Occluded segments are taken from io_pCache, if given and it has a pose for them; converted segments are stored in it.
+  // Returns INDEX_NONE on success, or the index of the segment that could not be converted.
+  using FSegmentConverter = int32 ( * )( TArrayView< const FViconRawSegment > i_Segments, const FVector* i_pHierarchyScales,
+                                         FViconSubjectPoseCache* io_pCache, TArrayView< FTransform > o_Poses );
+  // Convert i_NumMarkers flattened [x1, y1, z1, x2, ...] SDK marker translations to the same layout in Unreal space
+  using FMarkerConverter = void ( * )( const double* i_pTranslations, int32 i_NumMarkers, float* o_pMarkers );
+
+  // Converters indexed by the server Y up axis mapping, for a stream with the given scaling option
+  class FSegmentConverters
+  {
+  public:
+    FSegmentConverter RigidBody[ 2 ];
+    FSegmentConverter Skeleton[ 2 ];
+  };
+
+  static FSegmentConverters SelectSegmentConverters( bool i_bUseScaling );
+  static FMarkerConverter SelectMarkerConverter( bool i_bYUp );
+
+  // Linear map from SDK marker translations to Unreal space, in the upper 3x3 of the matrix: the mirror,
+  // mm to cm and, with Y up axis mapping, YUpRotation
+  static FMatrix MakeMarkerMatrix( bool i_bYUp );
+  // Transform i_NumMarkers flattened [x1, y1, z1, x2, ...] translations by the upper 3x3 of i_rMatrix
+  static void ConvertMarkerBatch( const double* i_pTranslations, int32 i_NumMarkers, const FMatrix& i_rMatrix, float* o_pMarkers );
+
+  // Order to visit bones in so that every parent comes before its children, given the parent index of each bone
+  // (INDEX_NONE for roots). Returns false if the parents do not form a hierarchy.
+  static bool SortBonesParentFirst( TArrayView< const int32 > i_BoneParents, TArray< int32 >& o_rOrder );
+  // Compose local poses into component space poses, visiting the bones in i_SolveOrder from SortBonesParentFirst
+  static void LocalToComponentSpace( TArrayView< const FTransform > i_LocalPoses, TArrayView< const int32 > i_BoneParents,
+                                     TArrayView< const int32 > i_SolveOrder, TArrayView< FTransform > o_ComponentPoses );
+};
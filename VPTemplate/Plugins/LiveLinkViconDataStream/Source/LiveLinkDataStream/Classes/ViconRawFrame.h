@@ -0,0 +1,209 @@
+// Copyright (c) 2021 Vicon Motion Systems Ltd. All Rights Reserved.
+
+#pragma once
+
+// =========================================================================
+// Raw per-frame data captured from the DataStream SDK.
+//
+// The acquisition thread copies everything it needs out of the SDK into a
+// FViconRawFrame, so the SDK is free to fetch the next frame while the
+// conversion thread turns the copy into LiveLink frame data.
+// Values are as reported by the SDK (Vicon axes, millimetres).
+// A frame is reused from slot to slot; Reset() keeps array allocations.
+// =========================================================================
+
+#include "CoreMinimal.h"
+#include "ViconNameRegistry.h"
+#include "ViconSkeletonTemplate.h"
+#include "LiveLinkRole.h"
+#include "LiveLinkTypes.h"
+#include "Misc/QualifiedFrameTime.h"
+#include "Templates/SubclassOf.h"
+
+#include <string>
+
+// Immutable description of a transform / animation subject, shared between the
+// acquisition thread cache and every raw frame that refers to it
+class FViconSubjectSchema
+{
+public:
+  // Bones, parents and markers, shared with every other subject labeled with the same skeleton
+  FViconSkeletonTemplatePtr Template;
+  // Product of the static scales from each bone up to the root, used to remove scale from the translation.
+  // (1, 1, 1) for the root. Static for a given calibration, so worked out once with the schema.
+  TArray< FVector > HierarchyScales;
+  // Static scale of each bone, (1, 1, 1) where the SDK reports none. Also static for a given calibration,
+  // so read with the schema rather than from the SDK every frame.
+  TArray< FVector > StaticScales;
+};
+
+using FViconSubjectSchemaPtr = TSharedPtr< const FViconSubjectSchema, ESPMode::ThreadSafe >;
+
+// Last good local pose of each bone of a subject, indexed like FViconSkeletonTemplate::Bones, used in place of
+// an occluded segment. Created and freed along with the subject's schema; only the conversion of its own
+// subject touches it, so subjects can be converted in parallel without locking.
+class FViconSubjectPoseCache
+{
+public:
+  explicit FViconSubjectPoseCache( int32 i_NumBones )
+  {
+    Poses.SetNum( i_NumBones );
+    bValid.Init( false, i_NumBones );
+  }
+
+  TArray< FTransform > Poses;
+  TArray< bool > bValid;
+};
+
+using FViconSubjectPoseCachePtr = TSharedPtr< FViconSubjectPoseCache, ESPMode::ThreadSafe >;
+
+// Static data to push to LiveLink before the frame data of the same raw frame
+class FViconStaticDataUpdate
+{
+public:
+  FName SubjectName;
+  TSubclassOf< ULiveLinkRole > Role;
+  FLiveLinkStaticDataStruct StaticData;
+};
+
+class FViconRawSegment
+{
+public:
+  double Translation[ 3 ];
+  double Rotation[ 4 ];
+  // Static scale of the segment, applied as the pose scale. Copied from the schema rather than read from the SDK.
+  double StaticScale[ 3 ];
+  // Translation was read and the segment is not occluded
+  bool bTranslationValid;
+  bool bRotationValid;
+  bool bHasStaticScale;
+};
+
+class FViconRawSubject
+{
+public:
+  FViconNamePtr Name;
+  FViconSubjectSchemaPtr Schema;
+  FViconSubjectPoseCachePtr PoseCache;
+
+  // Segment count reported for this frame, which may differ from the schema
+  unsigned int SegmentCount = 0;
+  TArray< FViconRawSegment > Segments;
+
+  // Flattened [x1, y1, z1, x2, y2, z2, ...] translations of Schema->Template->Markers
+  TArray< double > MarkerTranslations;
+  bool bMarkersValid = false;
+};
+
+class FViconRawCamera
+{
+public:
+  FViconNamePtr Name;
+
+  double Translation[ 3 ];
+  double Rotation[ 4 ];
+
+  double Resolution[ 2 ];
+  double FocalLength = 0.0;
+  double LensParameters[ 3 ];
+  double PrincipalPoint[ 2 ];
+};
+
+// LabeledMarker or UnlabeledMarker data
+class FViconRawMarkerSet
+{
+public:
+  void Reset()
+  {
+    bCountValid = false;
+    bTranslationsValid = false;
+    Count = 0;
+    Translations.Reset();
+  }
+
+  // Streaming of this marker type is enabled in the source settings
+  bool bEnabled = false;
+  bool bCountValid = false;
+  bool bTranslationsValid = false;
+  unsigned int Count = 0;
+  // Flattened [x1, y1, z1, x2, y2, z2, ...]
+  TArray< double > Translations;
+};
+
+// Values that are the same for everything in an SDK frame, fetched once per frame
+class FViconFrameContext
+{
+public:
+  uint32 FrameNumber = 0;
+  uint32 HardwareFrameNumber = 0;
+  // Frame rate reported by the server. 0 if unknown, e.g. for retimed data.
+  double FrameRateHz = 0.0;
+  // Server uses Y up axis mapping
+  bool bYUp = false;
+  bool bHasTimecode = false;
+  // Timecode of the frame, valid if bHasTimecode
+  FQualifiedFrameTime SceneTime;
+};
+
+class FViconRawFrame
+{
+public:
+  void Reset()
+  {
+    WakeCycles = 0;
+    Context = FViconFrameContext();
+    RemovedSubjects.Reset();
+    StaticDataUpdates.Reset();
+    NumSubjects = 0;
+    bComponentSpacePoses = false;
+    bHasCameraData = false;
+    NumCameras = 0;
+    bHasMarkerData = false;
+    LabeledMarkers.Reset();
+    UnlabeledMarkers.Reset();
+  }
+
+  // Elements past NumSubjects / NumCameras are kept around to reuse their allocations
+  FViconRawSubject& AddSubject()
+  {
+    if( NumSubjects == Subjects.Num() )
+    {
+      Subjects.AddDefaulted();
+    }
+    return Subjects[ NumSubjects++ ];
+  }
+
+  FViconRawCamera& AddCamera()
+  {
+    if( NumCameras == Cameras.Num() )
+    {
+      Cameras.AddDefaulted();
+    }
+    return Cameras[ NumCameras++ ];
+  }
+
+  // Drop the element returned by the last AddSubject / AddCamera, e.g. if capturing it failed
+  void DiscardLastSubject() { --NumSubjects; }
+  void DiscardLastCamera() { --NumCameras; }
+
+  // FPlatformTime::Cycles64 when the SDK handed us the frame
+  uint64 WakeCycles = 0;
+  FViconFrameContext Context;
+
+  // Applied in order before any frame data: removals, then static data
+  TArray< FName > RemovedSubjects;
+  TArray< FViconStaticDataUpdate > StaticDataUpdates;
+
+  TArray< FViconRawSubject > Subjects;
+  int32 NumSubjects = 0;
+  // Push the component space poses of skeletons as well as their local poses
+  bool bComponentSpacePoses = false;
+
+  bool bHasCameraData = false;
+  TArray< FViconRawCamera > Cameras;
+  int32 NumCameras = 0;
+
+  bool bHasMarkerData = false;
+  FViconRawMarkerSet LabeledMarkers;
+  FViconRawMarkerSet UnlabeledMarkers;
+};
@@ -0,0 +1,43 @@
+// Copyright (c) 2021 Vicon Motion Systems Ltd. All Rights Reserved.
+
+#pragma once
+
+// =========================================================================
+// On-disk cache of the subject schemas last seen from a server.
+//
+// Lets a source push the static data of its subjects to LiveLink as soon as
+// it is created, rather than once the first frame has arrived and every
+// schema has been read back from the SDK. Schemas loaded from disk are
+// checked against the stream like any other cached subject once frames
+// flow, and replaced if they changed.
+//
+// One small binary file per server and subject prefix, under
+// Saved/ViconDataStream/SchemaCache. The role of a subject follows from its
+// bone count, as it does for the live stream, so it is not stored.
+// =========================================================================
+
+#include "CoreMinimal.h"
+#include "ViconNamePool.h"
+#include "ViconRawFrame.h"
+
+class FViconCachedSchema
+{
+public:
+  FViconNameId SubjectName = 0;
+  FViconSubjectSchemaPtr Schema;
+};
+
+class FViconSchemaCache
+{
+public:
+  // File caching the schemas of the subjects streamed from i_rServerAddress with the given subject prefix
+  static FString GetFilePath( const FString& i_rServerAddress, const FString& i_rSubjectPrefix );
+
+  // Read the schemas from i_rFilePath, sharing skeleton templates through io_rTemplates.
+  // Returns false if there is no cache file, or it is not a cache file this version can read.
+  static bool Load( const FString& i_rFilePath, FViconSkeletonTemplateRegistry& io_rTemplates, TArray< FViconCachedSchema >& o_rSchemas );
+
+  // Encode the schemas, so that the file can be written off the calling thread
+  static void Encode( TArrayView< const FViconCachedSchema > i_Schemas, TArray< uint8 >& o_rBytes );
+  static bool Save( const FString& i_rFilePath, const TArray< uint8 >& i_rBytes );
+};
@@ -0,0 +1,66 @@
+// Copyright (c) 2021 Vicon Motion Systems Ltd. All Rights Reserved.
+
+#pragma once
+
+// =========================================================================
+// Skeleton templates, shared by every subject that uses them.
+//
+// Subjects labeled with the same Vicon skeleton, e.g. the actors of a crowd
+// or ensemble, have the same bones, parents and markers. Templates are
+// deduplicated by a hash of that content, so the names, the solve order and
+// the names of the LiveLink static data are held and built once per
+// distinct skeleton rather than once per subject. Anything that depends on
+// the calibration of a subject, such as its segment scales, stays in its
+// FViconSubjectSchema.
+//
+// Templates are immutable once registered and may be read from any thread.
+// Only the acquisition thread uses the registry.
+// =========================================================================
+
+#include "CoreMinimal.h"
+#include "ViconNamePool.h"
+
+class FViconSkeletonTemplate
+{
+public:
+  // Names in FViconNamePool
+  TArray< FViconNameId > Bones;
+  TArray< FViconNameId > Markers;
+  // Parent index of each bone, INDEX_NONE for the root, and the bones sorted so that parents come before
+  // their children. SolveOrder is empty if the parents do not form a hierarchy.
+  TArray< int32 > BoneParents;
+  TArray< int32 > SolveOrder;
+
+  // Names for the LiveLink static data: one per bone, and the marker count followed by the axes of each marker
+  TArray< FName > BoneNames;
+  TArray< FName > PropertyNames;
+
+  // Hash of the bones, parents and markers
+  uint64 Hash = 0;
+};
+
+using FViconSkeletonTemplatePtr = TSharedPtr< const FViconSkeletonTemplate, ESPMode::ThreadSafe >;
+
+class FViconSkeletonTemplateRegistry
+{
+public:
+  // Template with the given bones, markers and parents, shared with every subject that has the same ones.
+  // A template, with its solve order and LiveLink names, is only built if no subject in use has them.
+  FViconSkeletonTemplatePtr FindOrAdd( TArray< FViconNameId >&& i_rBones, TArray< FViconNameId >&& i_rMarkers, TArray< int32 >&& i_rBoneParents );
+
+  // Forget templates which are no longer used by any subject
+  void Prune();
+  void Empty() { m_Templates.Empty(); }
+
+  // Number of distinct templates in use
+  int32 Num() const;
+
+private:
+  // Property names of a subject's marker static data: the marker count, then _X, _Y and _Z of each marker
+  static TArray< FName > MarkerPropertiesFromNames( const TArray< FViconNameId >& i_rMarkerNames );
+
+  using FWeakTemplatePtr = TWeakPtr< const FViconSkeletonTemplate, ESPMode::ThreadSafe >;
+
+  // Templates by content hash. Templates are owned by the schemas of the subjects that use them.
+  TMap< uint64, TArray< FWeakTemplatePtr > > m_Templates;
+};
@@ -5,6 +5,7 @@
 #include "Algo/Transform.h"
 #include "Containers/StringConv.h"
 #include "Containers/UnrealString.h"
+#include "HAL/ThreadSafeBool.h"
 #include "ILiveLinkClient.h"
 #include "LiveLinkTypes.h"
 #include "Logging/LogMacros.h"
@@ -22,6 +23,9 @@ DECLARE_LOG_CATEGORY_CLASS( LogViconStream, Display, All )
 #include <DataStreamRetimingClient.h>
 #include <IDataStreamClientBase.h>
 
+#include "ViconPoseKernel.h"
+#include "ViconRawFrame.h"
+
 //// With the new move semantics behaviour of the LiveLink API,
 //// we may wish to rethink the use of this class and rely on
 //// querying the client for data we have added rather
@@ -54,6 +58,10 @@ enum EStreamMode
 
 // A Wrapper class converting data from Vicon
 // to Unreal
+//
+// The Capture* functions copy data out of the current SDK frame and must be called
+// from the thread that calls GetFrame. The conversion functions taking raw data do
+// not touch the SDK client and are called from the frame reader's conversion thread.
 class ViconStream
 {
 public:
@@ -62,9 +70,19 @@ public:
 
   EResult Connect( const FString& i_rServer, bool i_bRetimed, bool i_bLogOutput );
   EResult Reconnect();
+  // Bound the time Connect may block for. Only applies to the non-retimed client.
+  void SetConnectionTimeout( unsigned int i_TimeoutMs );
+  // Connect to every server concurrently and wait for one of them to deliver a frame, allowing each
+  // i_TimeoutMs to do so. Returns the index of the first server to deliver a frame, or INDEX_NONE,
+  // also as soon as i_rStop is set.
+  static int32 ProbeServers( const TArray< FString >& i_rServers, unsigned int i_TimeoutMs, const FThreadSafeBool& i_rStop );
   bool IsConnected() const;
   void Disconnect();
   unsigned int GetFrameNumber();
+  unsigned int GetHardwareFrameNumber();
+  // Capture the orientation, timecode and frame rate of the current frame. The frame numbers are left as they
+  // are, as the caller reads those first to decide whether the frame is new.
+  void CaptureFrameContext( FViconFrameContext& io_rContext );
 
   EResult SetLightWeightEnabled( bool i_bEnabled );
   void SetMarkerDataEnabled( bool i_bEnabled );
@@ -83,34 +101,45 @@ public:
   EResult GetSubjectName( int Index, FString& o_rName ) const;
 
   EResult GetSegmentCountForSubject( const std::string& i_rSubjectNme, unsigned int& o_rCount ) const;
-  EResult GetSegmentNameForSubject( const std::string& i_rSubjectNme, int Index, FString& o_rSegName ) const;
-  EResult GetSegmentParentNameForSubject( const std::string& i_rSubjectName, const std::string& i_rSegName, FString& o_rSegName ) const;
+  EResult GetSegmentNameForSubject( const std::string& i_rSubjectNme, int Index, FViconNameId& o_rSegName ) const;
+  EResult GetSegmentParentNameForSubject( const std::string& i_rSubjectName, const std::string& i_rSegName, FViconNameId& o_rSegName ) const;
 
-  EResult GetSegmentLocalPose( const std::string& i_rSubjectName, const std::string& i_rSegmentName, FTransform& o_rPose );
+  EResult CaptureSegment( const std::string& i_rSubjectName, const std::string& i_rSegmentName, FViconRawSegment& o_rSegment );
+  // Work out FViconSubjectSchema::HierarchyScales for the given bones of a subject
+  void GetHierarchyScales( const std::string& i_rSubjectName, const TArray< FViconNameId >& i_rBoneNames, TArray< FVector >& o_rScales );
+  // Read FViconSubjectSchema::StaticScales for the given bones of a subject
+  void GetStaticScales( const std::string& i_rSubjectName, const TArray< FViconNameId >& i_rBoneNames, TArray< FVector >& o_rScales );
+  // Capture poses and markers for the subject. Name, Schema and PoseCache of io_rSubject must already be set.
+  bool CaptureSubject( FViconRawSubject& io_rSubject );
 
-  bool GetPoseForSubject( const std::string& InName, const TArray< std::string >& BoneNames, const TArray<std::string>& MarkerNames, FLiveLinkFrameDataStruct& OutSubject );
-  EResult GetSubjectNames( TArray< FString >& SubjectNames );
+  // Safe to call for different subjects in parallel
+  bool GetPoseForSubject( const FViconFrameContext& i_rContext, const FViconRawSubject& i_rSubject, FLiveLinkFrameDataStruct& OutSubject );
+  EResult GetSubjectNames( TArray< FViconNameId >& SubjectNames );
 
   EResult GetRootPose( const std::string& i_rSubjectName, FVector& o_rPosition, FQuat& o_rOrientation );
 
   EResult GetDynamicCameraCount( int& o_rCount ) const;
 
   // change to set to be able to compare
-  EResult GetDynamicCameraNames( TSet< FString >& o_rNameList ) const;
+  EResult GetDynamicCameraNames( TSet< FViconNameId >& o_rNameList ) const;
+
+  EResult GetVideoCameraNames( TSet< FViconNameId >& o_rNameList ) const;
 
-  EResult GetVideoCameraNames( TSet< FString >& o_rNameList ) const;
+  // Capture the transform and lens data of a camera
+  EResult CaptureCamera( const std::string& i_rCameraName, FViconRawCamera& o_rCamera );
 
-  EResult GetCameraTransformFrameData( const std::string& i_rCameraName, FLiveLinkTransformFrameData& OutSubject );
+  EResult GetCameraTransformFrameData( const FViconFrameContext& i_rContext, const FViconRawCamera& i_rCamera, FLiveLinkTransformFrameData& OutSubject ) const;
   EResult GetLensStaticData( const std::string& i_rCameraName, FLiveLinkLensStaticData& LensStaticData );
-  EResult GetLensFrameData( const std::string& i_rCameraName, FLiveLinkLensFrameData& LensFrameData );
-
-  EResult GetMarkerNamesForSubject(const std::string& i_rSubjectName, TArray<std::string>& o_rNames);
-  // Gets positions of markers for subject as a flattened vector of the form [x1, y1, z1, x2, y2, z2, ...]
-  EResult GetMarkersForSubject(const std::string& i_rSubjectName, const TArray<std::string>& i_rMarkerNames,TArray <float>& o_rMarkerValues);
-  // Gets positions of labeled markers as a flattened vector of the form [x1, y1, z1, x2, y2, z2, ...]
-  EResult GetLabeledMarkers(TArrayView< float >& o_rMarkerList);
-  // Gets positions of unlabeled markers as a flattened vector of the form [x1, y1, z1, x2, y2, z2, ...]
-  EResult GetUnlabeledMarkers(TArrayView< float >& o_rMarkerList);
+  EResult GetLensFrameData( const FViconFrameContext& i_rContext, const FViconRawCamera& i_rCamera, FLiveLinkLensFrameData& LensFrameData ) const;
+
+  EResult GetMarkerNamesForSubject(const std::string& i_rSubjectName, TArray<FViconNameId>& o_rNames);
+  // Gets positions of the subject's markers as a flattened vector of the form [n, x1, y1, z1, x2, y2, z2, ...]
+  EResult GetMarkersForSubject(const FViconFrameContext& i_rContext, const FViconRawSubject& i_rSubject, TArray <float>& o_rMarkerValues) const;
+  // Capture labeled / unlabeled marker translations for the frame
+  EResult CaptureLabeledMarkers(FViconRawMarkerSet& o_rMarkers);
+  EResult CaptureUnlabeledMarkers(FViconRawMarkerSet& o_rMarkers);
+  // Gets positions of captured markers as a flattened vector of the form [x1, y1, z1, x2, y2, z2, ...]
+  void GetMarkers(const FViconFrameContext& i_rContext, const FViconRawMarkerSet& i_rMarkers, TArrayView< float >& o_rMarkerList) const;
   EResult GetMarkerCountForSubject(const std::string& i_rSubjectName, unsigned int& o_rMarkerCount);
   EResult GetUnlabeledMarkerCount(unsigned int& o_rCount);
   EResult GetLabeledMarkerCount(unsigned int& o_rCount);
@@ -123,9 +152,13 @@ public:
 
 private:
   EResult GetSegmentScale( const std::string& i_rSubjectName, const std::string& i_rSegmentName, FVector& o_rScale );
+  // Static scale of a single segment, (1, 1, 1) if the SDK reports none
+  bool GetSegmentStaticScale( const std::string& i_rSubjectName, const std::string& i_rSegmentName, FVector& o_rScale );
   bool IsViconServerYup();
-  // Apply corrections for Unreal coordinate system to marker locations from datastream
-  FVector HandleMarker(const double i_rTranslation[3]);
+  EResult CaptureMarkersForSubject( FViconRawSubject& io_rSubject );
+
+  // Pose converters specialised for m_bUseScaling
+  FViconPoseKernel::FSegmentConverters m_SegmentConverters;
 
   FString m_ServerIP;
   float m_Offset;
@@ -136,8 +169,6 @@ private:
 
   ViconDataStreamSDK::CPP::Client m_Client;
   ViconDataStreamSDK::CPP::RetimingClient m_RetimingClient;
-
-  std::map< std::pair< std::string, std::string >, FTransform > m_CachedSubject;
 };
 
 #ifdef RESTORE_POINT_CPP
@@ -9,12 +9,31 @@
 // Runs on a worker thread and receives skeleton data and bone
 // transformations for each frame of animation.
 // Pushes skeleton and frame data to the LiveLink client.
+//
+// Work is split over two threads:
+// - the acquisition thread (Run) only fetches frames and copies the data
+//   it needs out of the SDK into a raw frame slot,
+// - the conversion thread (RunConversion) converts raw frames to LiveLink
+//   frame data and pushes them.
+// The threads are connected by a lock-free single producer / single consumer
+// ring. If the conversion thread falls behind, the acquisition thread drops
+// whole frames rather than blocking the SDK.
 // =========================================================================
 
 #include "HAL/Runnable.h"
 #include "HAL/RunnableThread.h"
 #include "HAL/ThreadSafeBool.h"
+#include "HAL/ThreadSafeCounter.h"
+#include "Async/Future.h"
+#include <ViconFrameRing.h>
+#include <ViconFrameSequenceTracker.h>
+#include <ViconMarkerIndex.h>
+#include <ViconMarkerTracker.h>
+#include <ViconNameRegistry.h>
+#include <ViconRawFrame.h>
+#include <ViconSchemaCache.h>
 #include <ViconStream.h>
+#include <ViconStreamReaderStats.h>
 #include <DataStreamClient.h>
 
 class FLiveLinkViconDataStreamSource;
@@ -26,8 +45,16 @@ public:
   static ViconStreamProperties FromString( const FString& i_rPropsString );
   const FString ToString() const;
 
+  // Properties of each system to stream from: this one, followed by one per entry of m_AdditionalSystems.
+  // Additional systems share every other property.
+  TArray< ViconStreamProperties > GetSystems() const;
+
   FText m_ServerName;
   FText m_SubjectFilter;
+  // Prepended to the LiveLink name of every subject from this system
+  FText m_SubjectPrefix;
+  // Other systems streamed in parallel by the same source, as a comma separated list of Prefix=Server[:Port]
+  FText m_AdditionalSystems;
   uint32 m_PortNumber;
 
   bool m_bRetimed;
@@ -37,6 +64,14 @@ public:
   bool m_bScaled;
 
   bool m_bLogOutput;
+
+  // Probe every server in m_ServerName at once and connect to the first to deliver a frame,
+  // rather than leaving the SDK to try them in turn
+  bool m_bParallelConnect = false;
+  // Time each probe is given to connect and deliver a frame, and to connect to the server which won.
+  // At least MIN_PROBE_TIMEOUT_MS, as no probe could deliver a frame in less.
+  uint32 m_ProbeTimeoutMs = 500;
+  static const uint32 MIN_PROBE_TIMEOUT_MS;
 };
 
 class FViconStreamFrameReader : public FRunnable
@@ -60,49 +95,151 @@ public:
   void Shutdown();
 
   bool IsConnected() const;
+  // True while the reader is trying to get back a connection it lost
+  bool IsReconnecting() const { return m_bReconnecting; }
+  // Number of subjects kept in LiveLink with their last data while reconnecting
+  int32 GetHeldSubjectCount() const { return m_HeldSubjectCount.GetValue(); }
 
   FString ConstructServerAddress();
+  // Each server and port of ConstructServerAddress
+  TArray< FString > ConstructServerAddresses();
 
   void SetLightweightEnabled( bool i_bLightweight );
   void SetMarkerEnabled( bool i_bStreamMarker );
   void SetUnlabeledMarkerEnabled( bool i_bStreamMarker );
   void ShowAllVideoCamera( bool i_bShow );
+  void SetEventDrivenFrameWait( bool i_bEventDriven, int32 i_TimeoutMs );
+  void SetLatestFrameOnly( bool i_bLatestFrameOnly );
+  // Also push the component space poses of each skeleton, as a subject of its own
+  void SetComponentSpacePoses( bool i_bComponentSpacePoses );
+  // Give unlabeled markers persistent ids, keeping a marker's id while it moves less than i_GateDistance (cm)
+  // from where it was predicted to be
+  void SetUnlabeledMarkerTracking( bool i_bTrack, float i_GateDistance );
+  // Publish a spatial index of each frame's markers for FViconMarkerIndexRegistry queries
+  void SetMarkerIndexEnabled( bool i_bEnabled );
+  // Convert subjects on up to this many task graph workers. 0 or 1 converts them on the conversion thread only.
+  void SetSubjectConversionWorkers( int32 i_NumWorkers );
+  // Priority and core affinity of the reader threads. An affinity mask of 0 lets the OS choose, a dedicated
+  // core of -1 disables pinning the acquisition thread.
+  void SetSchedulingProfile( EThreadPriority i_Priority, uint64 i_AffinityMask, int32 i_DedicatedCore );
+
+  const FString& GetSubjectPrefix() const { return m_SubjectPrefix; }
+  const FViconStreamReaderStats& GetStats() const { return m_Stats; }
+  const FViconFrameSequenceTracker& GetFrameSequence() const { return m_FrameSequence; }
 
 private:
   // Cached representation of static data for transform / animation subjects
   class FCachedSubject
   {
   public:
-    TArray<std::string> Markers;
-    TArray<std::string> Bones;
+    FViconNamePtr Name;
+    FViconSubjectSchemaPtr Schema;
+    FViconSubjectPoseCachePtr PoseCache;
+    // Last time the subject was in the stream, used to forget subjects which have left
+    double LastSeenSeconds = 0.0;
+
+    // Cheap fingerprint of the schema, checked every frame. The schema is only compared name by name
+    // when the fingerprint changes, or when the periodic audit is due.
+    int32 SubjectIndex = INDEX_NONE;
+    unsigned int SegmentCount = 0;
+    unsigned int MarkerCount = 0;
+    double NextAuditSeconds = 0.0;
+
+    // Loaded from the schema cache on disk and not yet checked against the stream. The first check also
+    // compares the bone parents, which are otherwise only read from the SDK when the static data is built.
+    bool bFromSchemaCache = false;
   };
 
   // Cached representation of unordered marker subjects (LabeledMarker and UnlabeledMarker)
   class FCachedMarker
   {
   public:
-    // Maximum number of marker type seen. 
-    // This is used to set the size of the marker data vector so that the static
+    // Maximum number of marker type seen, until it shrinks after a sustained drop.
+    // This is the capacity of the point cloud frames, so that the static
     // data does not need to be updated regularly
     unsigned int MaxCount = 0;
+    // Time the marker count fell below the shrink threshold, negative while it is above,
+    // and the largest count seen since
+    double BelowThresholdSinceSeconds = -1.0;
+    unsigned int PeakCountBelowThreshold = 0;
+    double LastResizeSeconds = -1.0e9;
     // Whether the subject has been added / removed from the live link stream.
     // We need this in the struct so that we can keep track of the count even
     // if the subject drops out
     bool SubjectPresent = false;
   };
 
-  void HandleSubjectData();
-  void HandleCameraData();
-  void HandleMarkerData();
-  bool AddSubjectStaticDataToLiveLink( const FString& i_rSubjectName, TArray< std::string >& o_rSubjectBones, TArray<std::string>& o_rMarkerNames );
-  void ClearCamerasFromLiveLink( const TSet< FString >& i_rStaleCameras );
-  void ClearMarkerFromLiveLink( const FLiveLinkSubjectKey& i_rMarkerKey );
+  class FSchedulingProfile
+  {
+  public:
+    EThreadPriority Priority = TPri_BelowNormal;
+    uint64 AffinityMask = 0;
+    int32 DedicatedCore = -1;
+  };
 
-  // Handle markers not attached to subjects
-  void HandleMarkerData(bool bLabeled);
+  // Runs the conversion thread
+  class FConversionRunnable : public FRunnable
+  {
+  public:
+    explicit FConversionRunnable( FViconStreamFrameReader& i_rReader )
+    : m_rReader( i_rReader )
+    {
+    }
 
-  // Utility to get a list of property names of the form {index}_{axis}
-  TArray<FName> GetGenericMarkerPropertyNames(unsigned int MarkerCount);
+    virtual uint32 Run() override;
+
+  private:
+    FViconStreamFrameReader& m_rReader;
+  };
+
+  // Acquisition thread: capture the current SDK frame into io_rFrame
+  void HandleSubjectData( FViconRawFrame& io_rFrame );
+  void HandleCameraData( FViconRawFrame& io_rFrame );
+  void HandleMarkerData( FViconRawFrame& io_rFrame );
+  bool AddSubjectStaticDataToLiveLink( FViconNameId i_SubjectName, FCachedSubject& o_rCachedSubject, FViconRawFrame& io_rFrame );
+  // Static data of a transform or animation subject with the given schema
+  FViconStaticDataUpdate MakeSubjectStaticData( const FViconName& i_rName, const FViconSubjectSchema& i_rSchema );
+  // Static data of the component space subject of a skeleton, which has the skeleton's bones with no parents
+  void AddComponentSpaceStaticData( const FViconName& i_rName, const FViconSubjectSchema& i_rSchema, FViconRawFrame& io_rFrame );
+  // Add or remove the component space subjects of the cached skeletons if the option changed
+  void UpdateComponentSpaceSubjects( FViconRawFrame& io_rFrame );
+  // Check the cached schema of a subject still matches the stream. Returns false if it changed.
+  bool ValidateCachedSubject( int32 i_SubjectIndex, FCachedSubject& io_rCachedSubject );
+  void ScheduleSchemaAudit( FCachedSubject& io_rCachedSubject ) const;
+  // Forget subjects which have not been in the stream for a while, along with their pose caches
+  void PruneCachedSubjects( double i_NowSeconds );
+  // Push the static data of the subjects last seen from this server to LiveLink, before the first frame arrives
+  void WarmStartFromSchemaCache();
+  // Remove the subjects pushed from the schema cache which the first frame of the stream did not have
+  void RemoveUnconfirmedWarmStartSubjects( FViconRawFrame& io_rFrame );
+  // Write the schemas of the cached subjects to disk if they changed, off the acquisition thread unless i_bBlocking
+  void SaveSchemaCache( bool i_bBlocking );
+  // Names of the subjects in the subject filter, empty if every subject is allowed
+  TSet< FViconNameId > ParseSubjectFilter() const;
+  void ClearCamerasFromLiveLink( const TSet< FViconNameId >& i_rStaleCameras, FViconRawFrame& io_rFrame );
+
+  // Conversion thread: push io_rFrame to LiveLink
+  uint32 RunConversion();
+  // Release all but the newest raw frame in the ring without converting them. Returns the newest frame.
+  FViconRawFrame* CoalesceFrames();
+  // Apply the subject removals and static data carried by a raw frame
+  void ApplyFrameEvents( FViconRawFrame& io_rFrame );
+  void ConvertFrame( FViconRawFrame& io_rFrame );
+  void PushSubjectData( const FViconRawFrame& i_rFrame );
+  void PushCameraData( const FViconRawFrame& i_rFrame );
+  void ClearMarkerFromLiveLink( const FLiveLinkSubjectKey& i_rMarkerKey );
+
+  // Handle markers not attached to subjects, which are pushed with the point cloud role.
+  // The markers pushed are also added to io_pMarkerIndex, if any.
+  void PushMarkerData( bool bLabeled, const FViconFrameContext& i_rContext, const FViconRawMarkerSet& i_rMarkers, FViconMarkerIndex* io_pMarkerIndex );
+  // Marker index to build for a frame, or nullptr if the index is disabled. An index no longer referenced by
+  // any query is reused.
+  FViconMarkerIndex* BeginMarkerIndex( const FViconFrameContext& i_rContext );
+  void PublishMarkerIndex();
+  void WithdrawMarkerIndex();
+  // Grow the capacity of a marker subject at once to fit i_MarkerCount, or shrink it once the count has stayed well
+  // below it for a while. Returns true if the capacity changed.
+  bool UpdateMarkerCapacity( FCachedMarker& io_rCachedMarker, unsigned int i_MarkerCount, double i_NowSeconds );
 
   // Disable interpolation of property values for subject frame data
   // Key is passed in by value rather than const reference to match the 
@@ -111,28 +248,122 @@ private:
 
 private:
   void ConnectInternal();
+  // Called on the acquisition thread when the connection drops, and when it is back
+  void OnConnectionLost();
+  void OnConnectionRestored();
+
+  // Switch the stream mode to match the requested frame wait mode. Called on the reader thread.
+  void UpdateFrameWaitMode();
+  // Back off after GetFrame failed or returned a frame we have already seen
+  void WaitForNextFrame();
+  void RecordWakeToPush( uint64 i_WakeCycles );
+  void RecordArrival( uint64 i_WakeCycles );
+  // Track the frame sequence of the current SDK frame. Returns false if the frame is not a new frame.
+  bool TrackFrameSequence( const FViconFrameContext& i_rContext );
+  // Apply the scheduling profile to the calling reader thread if it changed since io_rAppliedVersion
+  void UpdateScheduling( bool i_bAcquisitionThread, int32& io_rAppliedVersion );
 
-  // Adds _X, _Y, and _Z to the marker names, returning a list whose length is three times the input
-  TArray<FName> MarkerPropertiesFromNames(const TArray<std::string>& i_rMarkerNames);
+  // Record the scene time and server frame rate of the frame being pushed, used to compare systems
+  void RecordFrameContext( const FViconFrameContext& i_rContext );
 
   ILiveLinkClient* m_pLiveLinkClient;
   ViconStreamProperties m_ViconStreamProps;
+  FString m_SubjectPrefix;
   FGuid m_SourceGuid;
 
-  int32 m_LastFrameNumber;
   FThreadSafeBool m_bStopTask;
   FRunnableThread* m_pThread;
   FCriticalSection* m_pMutex;
 
+  FConversionRunnable m_ConversionRunnable;
+  FRunnableThread* m_pConversionThread;
+  // Raw frames handed from the acquisition thread to the conversion thread
+  TViconFrameRing< FViconRawFrame > m_FrameRing;
+  // Triggered when a raw frame has been committed to the ring, or on Stop()
+  FEvent* m_pFrameReadyEvent;
+  // Convert only the newest raw frame, set from the game thread
+  FThreadSafeBool m_bLatestFrameOnly;
+  FThreadSafeCounter m_SubjectConversionWorkers;
+  // Per subject conversion results, reused between frames by the conversion thread
+  TArray< FLiveLinkFrameDataStruct > m_SubjectFrameData;
+  TArray< bool > m_SubjectConverted;
+  // Component space poses of the skeletons in m_SubjectFrameData, if the frame has them
+  TArray< FLiveLinkFrameDataStruct > m_SubjectComponentSpaceData;
+  TArray< bool > m_SubjectHasComponentSpace;
+
+  // Requested component space poses option, set from the game thread, and the option last applied on the acquisition thread
+  FThreadSafeBool m_bComponentSpacePoses;
+  bool m_bComponentSpacePosesApplied;
+
+  // Requested scheduling profile, set from the game thread
+  FCriticalSection m_SchedulingMutex;
+  FSchedulingProfile m_SchedulingProfile;
+  FThreadSafeCounter m_SchedulingVersion;
+
+  // Requested frame wait mode, set from the game thread
+  FThreadSafeBool m_bEventDrivenWait;
+  FThreadSafeCounter m_FrameWaitTimeoutMs;
+  // Frame wait mode last applied on the reader thread
+  bool m_bEventDrivenWaitApplied;
+  // True while the event driven wait has put the stream in ServerPush and GetFrame blocks until the next frame
+  FThreadSafeBool m_bServerPushWait;
+  // Held by the reader around connecting and disconnecting m_DataStream, and while it captures a frame, so that
+  // the forced disconnect on destruction can't race with them. GetFrame is called outside it, as that disconnect
+  // is what releases it.
+  FCriticalSection m_ConnectionMutex;
+  // Set while reconnecting after the connection dropped
+  FThreadSafeBool m_bReconnecting;
+  FThreadSafeCounter m_HeldSubjectCount;
+  // Set while ConnectInternal is blocked in Connect, holding m_ConnectionMutex
+  FThreadSafeBool m_bConnecting;
+
+  // Triggered by Stop() so that a waiting reader wakes up immediately
+  FEvent* m_pFrameWaitEvent;
+  // Triggered when Run() returns
+  FEvent* m_pRunFinishedEvent;
+
+  FViconStreamReaderStats m_Stats;
+  FViconFrameSequenceTracker m_FrameSequence;
+  // Sequence counts last published to the stats system
+  FViconFrameSequenceCounts m_PublishedSequenceCounts;
+  // Next time the conversion thread publishes the gauge stats of all readers
+  double m_NextGaugeStatSeconds = 0.0;
+
   ViconStream m_DataStream;
 
-  TMap< FString, FCachedSubject> m_CachedSubjects;
-  TSet< FString > m_CachedCameras;
-  TMap< FString, FCachedMarker> m_CachedMarkers;
+  // Owned by the acquisition thread
+  FViconNameRegistry m_Names;
+  FViconSkeletonTemplateRegistry m_SkeletonTemplates;
+  // Keyed by FViconNamePool id
+  TMap< FViconNameId, FCachedSubject > m_CachedSubjects;
+  double m_NextSubjectPruneSeconds;
+  // Schema cache file for this server, and whether m_CachedSubjects changed since it was last written
+  FString m_SchemaCachePath;
+  bool m_bSchemaCacheDirty;
+  // Subjects were pushed from the schema cache and the stream has not yet reported its subjects
+  bool m_bWarmStartPending;
+  double m_NextSchemaCacheSaveSeconds;
+  // Last write of the schema cache, finished before the next one starts
+  TFuture< bool > m_SchemaCacheSave;
+  TSet< FViconNameId > m_CachedCameras;
+  // Owned by the conversion thread
+  TMap< FName, FCachedMarker> m_CachedMarkers;
+  FViconMarkerTracker m_UnlabeledMarkerTracker;
+  // Requested unlabeled marker tracking, set from the game thread
+  FThreadSafeBool m_bTrackUnlabeledMarkers;
+  std::atomic< float > m_UnlabeledMarkerGateDistance;
+  // Index being built for the current frame, and the one last published
+  TSharedPtr< FViconMarkerIndex, ESPMode::ThreadSafe > m_MarkerIndex;
+  TSharedPtr< FViconMarkerIndex, ESPMode::ThreadSafe > m_PublishedMarkerIndex;
+  // Requested marker index, set from the game thread
+  FThreadSafeBool m_bPublishMarkerIndex;
+  // LiveLink names of the labeled and unlabeled marker subjects
+  const FName m_LabeledMarkerName;
+  const FName m_UnlabeledMarkerName;
   bool m_bLightweight;
   bool m_bLabeledMarker;
   bool m_bUnlabeledMarker;
   bool m_bShowAllVideoCamera;
-  TArray< FString > m_SubjectAllowed;
+  TSet< FViconNameId > m_SubjectAllowed;
 
 };
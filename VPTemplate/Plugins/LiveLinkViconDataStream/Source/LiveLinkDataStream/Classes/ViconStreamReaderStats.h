@@ -0,0 +1,209 @@
+// Copyright (c) 2021 Vicon Motion Systems Ltd. All Rights Reserved.
+
+#pragma once
+
+// =========================================================================
+// Counters published by the Vicon Data Stream frame reader.
+//
+// Fields are written by the reader threads and may be read from any thread,
+// e.g. for the LiveLink source status or for diagnostics.
+// They are also published to the STATGROUP_ViconDataStream stat group
+// ("stat ViconDataStream"), which all sources share: counts are summed over
+// the readers, latencies, ages and jitter are the worst reader's, and ring
+// depth and marker capacity are summed.
+// =========================================================================
+
+#include "CoreMinimal.h"
+#include "HAL/PlatformTime.h"
+#include "Stats/Stats.h"
+
+#include <atomic>
+
+DECLARE_STATS_GROUP( TEXT( "Vicon DataStream" ), STATGROUP_ViconDataStream, STATCAT_Advanced );
+
+// Fixed bucket histogram of millisecond samples. Written by a single thread, readable from any thread.
+class FViconJitterHistogram
+{
+public:
+  static constexpr int32 NumBuckets = 1000;
+  static constexpr double BucketWidthMs = 0.05;
+
+  FViconJitterHistogram()
+  {
+    Reset();
+  }
+
+  void Reset()
+  {
+    for( std::atomic< uint32 >& rBucket : m_Buckets )
+    {
+      rBucket.store( 0, std::memory_order_relaxed );
+    }
+    m_Count = 0;
+    m_MaxMs = 0.0;
+  }
+
+  void Add( double i_SampleMs )
+  {
+    // Samples past the last bucket are accumulated in the overflow bucket
+    const int32 Bucket = FMath::Clamp( static_cast< int32 >( i_SampleMs / BucketWidthMs ), 0, NumBuckets );
+    m_Buckets[ Bucket ].fetch_add( 1, std::memory_order_relaxed );
+    ++m_Count;
+    if( i_SampleMs > m_MaxMs )
+    {
+      m_MaxMs = i_SampleMs;
+    }
+  }
+
+  // Upper edge of the bucket containing the given percentile (0-100), or the max for the overflow bucket
+  double GetPercentileMs( double i_Percentile ) const
+  {
+    const uint64 Count = m_Count;
+    if( Count == 0 )
+    {
+      return 0.0;
+    }
+    const uint64 Rank = FMath::Max< uint64 >( 1, static_cast< uint64 >( FMath::CeilToDouble( Count * i_Percentile / 100.0 ) ) );
+    uint64 Seen = 0;
+    for( int32 Bucket = 0; Bucket < NumBuckets; ++Bucket )
+    {
+      Seen += m_Buckets[ Bucket ].load( std::memory_order_relaxed );
+      if( Seen >= Rank )
+      {
+        return ( Bucket + 1 ) * BucketWidthMs;
+      }
+    }
+    return m_MaxMs;
+  }
+
+  double GetMaxMs() const { return m_MaxMs; }
+  uint64 Num() const { return m_Count; }
+
+private:
+  std::atomic< uint32 > m_Buckets[ NumBuckets + 1 ];
+  std::atomic< uint64 > m_Count;
+  std::atomic< double > m_MaxMs;
+};
+
+class FViconStreamReaderStats
+{
+public:
+  // Time from the DataStream SDK handing us a new frame to the last LiveLink push for that frame
+  std::atomic< double > LastWakeToPushMs{ 0.0 };
+  std::atomic< double > MaxWakeToPushMs{ 0.0 };
+  // Exponential moving average of the wake to push latency
+  std::atomic< double > AverageWakeToPushMs{ 0.0 };
+
+  // Frames fetched from the SDK and handed to the conversion thread
+  std::atomic< uint64 > FramesAcquired{ 0 };
+  // Frames waiting in the ring for the conversion thread, as of the last frame acquired
+  std::atomic< int32 > FrameRingDepth{ 0 };
+  // Frames dropped by the acquisition thread because the conversion thread was a full ring behind
+  std::atomic< uint64 > FramesDropped{ 0 };
+  // Connection attempts after the first, and how many of them succeeded
+  std::atomic< uint64 > ReconnectAttempts{ 0 };
+  std::atomic< uint64 > Reconnects{ 0 };
+  // Frames superseded by a newer frame before conversion started, in latest frame only mode
+  std::atomic< uint64 > FramesCoalesced{ 0 };
+  std::atomic< uint64 > FramesPushed{ 0 };
+  // Number of times the reader gave up waiting for a frame and re-checked for shutdown
+  std::atomic< uint64 > FrameWaitTimeouts{ 0 };
+  // Full comparisons of a cached subject schema against the stream, because its fingerprint changed or
+  // because the periodic audit was due, and how many of them found the schema had changed
+  std::atomic< uint64 > SchemaRevalidations{ 0 };
+  std::atomic< uint64 > SchemaAudits{ 0 };
+  std::atomic< uint64 > SchemaChanges{ 0 };
+  // Subjects pushed from the schema cache on disk before the first frame, and how many of them the stream
+  // then confirmed or found to have changed
+  std::atomic< uint64 > SchemaCacheWarmStarts{ 0 };
+  std::atomic< uint64 > SchemaCacheHits{ 0 };
+  std::atomic< uint64 > SchemaCacheMisses{ 0 };
+  // Distinct skeleton templates shared by the subjects being streamed
+  std::atomic< int32 > SkeletonTemplates{ 0 };
+  // Points in each frame of the LabeledMarker and UnlabeledMarker subjects, and how often either was resized
+  std::atomic< int32 > LabeledMarkerCapacity{ 0 };
+  std::atomic< int32 > UnlabeledMarkerCapacity{ 0 };
+  std::atomic< uint64 > MarkerCapacityResizes{ 0 };
+  // Unlabeled markers being tracked, including ones which dropped out in the last few frames
+  std::atomic< int32 > UnlabeledMarkerTracks{ 0 };
+  // Markers in the last published marker index
+  std::atomic< int32 > IndexedMarkers{ 0 };
+
+  // Age of the frame being converted when conversion started
+  std::atomic< double > LastFrameAgeMs{ 0.0 };
+  std::atomic< double > MaxFrameAgeMs{ 0.0 };
+
+  void RecordFrameAge( uint64 i_WakeCycles )
+  {
+    const double AgeMs = FPlatformTime::ToMilliseconds64( FPlatformTime::Cycles64() - i_WakeCycles );
+    LastFrameAgeMs = AgeMs;
+    if( AgeMs > MaxFrameAgeMs )
+    {
+      MaxFrameAgeMs = AgeMs;
+    }
+  }
+
+  // Timecode of the last frame pushed, in seconds since midnight. Negative if the frame had no timecode.
+  std::atomic< double > LastSceneTimeSeconds{ -1.0 };
+  // Frame rate reported by the server for the last frame pushed. 0 if unknown.
+  std::atomic< double > ServerFrameRateHz{ 0.0 };
+
+  // Deviation of each new frame's arrival interval from the average interval, measured on the acquisition thread
+  FViconJitterHistogram ArrivalJitter;
+  // Percentiles of ArrivalJitter, updated every so many frames as working them out scans the histogram
+  std::atomic< double > ArrivalJitterP50Ms{ 0.0 };
+  std::atomic< double > ArrivalJitterP99Ms{ 0.0 };
+  std::atomic< double > AverageArrivalIntervalMs{ 0.0 };
+
+  // Record the arrival of a new frame at i_WakeCycles (FPlatformTime::Cycles64). Called from the acquisition thread only.
+  void RecordArrival( uint64 i_WakeCycles )
+  {
+    if( m_LastArrivalCycles != 0 )
+    {
+      const double IntervalMs = FPlatformTime::ToMilliseconds64( i_WakeCycles - m_LastArrivalCycles );
+      const uint64 Count = ++m_ArrivalIntervals;
+      if( Count > 1 )
+      {
+        ArrivalJitter.Add( FMath::Abs( IntervalMs - AverageArrivalIntervalMs ) );
+      }
+      const double Alpha = Count < 100 ? 1.0 / Count : 0.01;
+      AverageArrivalIntervalMs = AverageArrivalIntervalMs + ( IntervalMs - AverageArrivalIntervalMs ) * Alpha;
+    }
+    m_LastArrivalCycles = i_WakeCycles;
+  }
+
+  // Don't measure an interval across the next frame, e.g. after reconnecting. Called from the acquisition thread only.
+  void RestartArrivals()
+  {
+    m_LastArrivalCycles = 0;
+  }
+
+  // Start a new jitter measurement, e.g. after the scheduling profile changed. Called from the acquisition thread only.
+  void ResetArrivalJitter()
+  {
+    ArrivalJitter.Reset();
+    AverageArrivalIntervalMs = 0.0;
+    m_LastArrivalCycles = 0;
+    m_ArrivalIntervals = 0;
+  }
+
+  // Record the latency of a frame which became available at i_WakeCycles (FPlatformTime::Cycles64)
+  void RecordWakeToPush( uint64 i_WakeCycles )
+  {
+    const double LatencyMs = FPlatformTime::ToMilliseconds64( FPlatformTime::Cycles64() - i_WakeCycles );
+    const uint64 Count = FramesPushed.fetch_add( 1 ) + 1;
+
+    LastWakeToPushMs = LatencyMs;
+    if( LatencyMs > MaxWakeToPushMs )
+    {
+      MaxWakeToPushMs = LatencyMs;
+    }
+    // Plain average for the first frames so the moving average doesn't start from zero
+    const double Alpha = Count < 100 ? 1.0 / Count : 0.01;
+    AverageWakeToPushMs = AverageWakeToPushMs + ( LatencyMs - AverageWakeToPushMs ) * Alpha;
+  }
+
+private:
+  uint64 m_LastArrivalCycles = 0;
+  uint64 m_ArrivalIntervals = 0;
+};
@@ -10,10 +10,27 @@
 #include "LiveLinkViconDataStreamSource.h"
 #include "Misc/Timecode.h"
 #include "Roles/LiveLinkBasicTypes.h"
+#include "LiveLinkViconPointCloudRole.h"
 #include "LiveLinkViconUtils.h"
+#include "ViconMarkerIndex.h"
 
 const std::string ULiveLinkViconDataStreamBlueprint::SOURCE_TYPE = "Vicon Live Link";
 
+namespace
+{
+  FViconMarkerQueryResult MakeMarkerQueryResult( const FViconMarkerIndex& i_rIndex, int32 i_Marker, const FVector& i_rLocation, bool i_bDistance )
+  {
+    const FViconMarkerIndex::FMarker& rMarker = i_rIndex.GetMarker( i_Marker );
+    FViconMarkerQueryResult Result;
+    Result.Subject = i_rIndex.GetSubjectNames()[ rMarker.Subject ];
+    Result.PointIndex = rMarker.PointIndex;
+    Result.Id = rMarker.Id;
+    Result.Translation = FVector( rMarker.Position );
+    Result.Distance = i_bDistance ? FVector::Dist( i_rLocation, Result.Translation ) : 0.0f;
+    return Result;
+  }
+}
+
 void ULiveLinkViconDataStreamBlueprint::CreateViconLiveLinkSource( FString ServerName, int32 PortNumber, FString SubjectFilter, bool bIsRetimed, bool bUsePreFetch, bool bIsScaled, bool bLogOutput, float Offset, FLiveLinkSourceHandle& SourceHandle )
 {
   IModularFeatures& ModularFeatures = IModularFeatures::Get();
@@ -74,3 +91,69 @@ bool ULiveLinkViconDataStreamBlueprint::GetMarkerTranslations(
     return LiveLinkViconUtils::GetMarkerTranslations(BasicData.FrameData.PropertyValues, Translations);
 }
 
+bool ULiveLinkViconDataStreamBlueprint::GetPointCloudTranslations(
+  UPARAM(ref) FLiveLinkViconPointCloudBlueprintData& PointCloudData, TArray<FVector>& Translations)
+{
+  return LiveLinkViconUtils::GetMarkerTranslations(PointCloudData.FrameData, Translations);
+}
+
+bool ULiveLinkViconDataStreamBlueprint::FindNearestMarker(FVector Location, float MaxDistance, FViconMarkerQueryResult& Marker)
+{
+  TArray< FViconMarkerIndexPtr > Indices;
+  FViconMarkerIndexRegistry::GetPublished( Indices );
+
+  // Each source's search is limited to the nearest marker found in the sources before it
+  const FVector3f Location3f( Location );
+  float BestDistance = MaxDistance > 0.0f ? MaxDistance : UE_MAX_FLT;
+  bool bFound = false;
+  for( const FViconMarkerIndexPtr& rIndex : Indices )
+  {
+    const int32 MarkerIndex = rIndex->FindNearest( Location3f, BestDistance );
+    if( MarkerIndex != INDEX_NONE )
+    {
+      Marker = MakeMarkerQueryResult( *rIndex, MarkerIndex, Location, true );
+      BestDistance = Marker.Distance;
+      bFound = true;
+    }
+  }
+  return bFound;
+}
+
+bool ULiveLinkViconDataStreamBlueprint::FindMarkersInRadius(FVector Location, float Radius, TArray<FViconMarkerQueryResult>& Markers)
+{
+  Markers.Reset();
+  TArray< FViconMarkerIndexPtr > Indices;
+  FViconMarkerIndexRegistry::GetPublished( Indices );
+
+  TArray< int32 > Found;
+  for( const FViconMarkerIndexPtr& rIndex : Indices )
+  {
+    Found.Reset();
+    rIndex->FindInRadius( FVector3f( Location ), Radius, Found );
+    for( const int32 MarkerIndex : Found )
+    {
+      Markers.Add( MakeMarkerQueryResult( *rIndex, MarkerIndex, Location, true ) );
+    }
+  }
+  Markers.Sort( []( const FViconMarkerQueryResult& i_rA, const FViconMarkerQueryResult& i_rB ) { return i_rA.Distance < i_rB.Distance; } );
+  return Markers.Num() > 0;
+}
+
+bool ULiveLinkViconDataStreamBlueprint::FindMarkersInBox(FBox Box, TArray<FViconMarkerQueryResult>& Markers)
+{
+  Markers.Reset();
+  TArray< FViconMarkerIndexPtr > Indices;
+  FViconMarkerIndexRegistry::GetPublished( Indices );
+
+  TArray< int32 > Found;
+  for( const FViconMarkerIndexPtr& rIndex : Indices )
+  {
+    Found.Reset();
+    rIndex->FindInBox( FBox3f( Box ), Found );
+    for( const int32 MarkerIndex : Found )
+    {
+      Markers.Add( MakeMarkerQueryResult( *rIndex, MarkerIndex, FVector::ZeroVector, false ) );
+    }
+  }
+  return Markers.Num() > 0;
+}
@@ -4,37 +4,93 @@
 #include "ILiveLinkDataStreamModule.h"
 #include "LiveLinkViconDataStreamSourceSettings.h"
 
+namespace
+{
+  EThreadPriority ToThreadPriority( EViconReaderThreadPriority i_Priority )
+  {
+    switch( i_Priority )
+    {
+    case EViconReaderThreadPriority::Normal:
+      return TPri_Normal;
+    case EViconReaderThreadPriority::AboveNormal:
+      return TPri_AboveNormal;
+    case EViconReaderThreadPriority::Highest:
+      return TPri_Highest;
+    case EViconReaderThreadPriority::TimeCritical:
+      return TPri_TimeCritical;
+    default:
+      return TPri_BelowNormal;
+    }
+  }
+
+  FString GetReaderStatus( const FViconStreamFrameReader& i_rReader )
+  {
+    if( !i_rReader.IsConnected() )
+    {
+      if( i_rReader.IsReconnecting() )
+      {
+        return FString::Printf( TEXT( "Reconnecting (%d subjects held)" ), i_rReader.GetHeldSubjectCount() );
+      }
+      return TEXT( "Not Connected" );
+    }
+
+    const double FrameRateHz = i_rReader.GetStats().ServerFrameRateHz;
+    const FString Connected = FrameRateHz > 0.0 ? FString::Printf( TEXT( "Connected at %.0f Hz" ), FrameRateHz ) : FString( TEXT( "Connected" ) );
+
+    // Frame loss over the last complete window, so problems on the tracking network are visible at a glance
+    const FViconFrameSequenceCounts Counts = i_rReader.GetFrameSequence().GetWindowCounts();
+    if( Counts.Gaps == 0 && Counts.HardwareGaps == 0 && Counts.Duplicates == 0 && Counts.Reorders == 0 )
+    {
+      return Connected;
+    }
+    return FString::Printf( TEXT( "%s (last %.0fs: %llu gaps / %llu frames missed, %llu hardware gaps, %llu duplicates, %llu reorders)" ),
+                            *Connected, FViconFrameSequenceTracker::WindowSeconds, Counts.Gaps, Counts.FramesMissed,
+                            Counts.HardwareGaps, Counts.Duplicates, Counts.Reorders );
+  }
+}
+
 FLiveLinkViconDataStreamSource::FLiveLinkViconDataStreamSource( const FText& InSourceType, const ViconStreamProperties& InViconStreamProps )
 : SourceType( InSourceType )
 , ViconStreamProps( InViconStreamProps )
-, ViconStreamFrameReader( nullptr )
 {
 }
 
 FLiveLinkViconDataStreamSource::~FLiveLinkViconDataStreamSource()
 {
-  if( ViconStreamFrameReader != nullptr )
+  // Stop all readers before waiting on any of them
+  for( FViconStreamFrameReader* pReader : ViconStreamFrameReaders )
+  {
+    pReader->Shutdown();
+  }
+  for( FViconStreamFrameReader* pReader : ViconStreamFrameReaders )
   {
-    delete ViconStreamFrameReader;
-    ViconStreamFrameReader = nullptr;
+    delete pReader;
   }
+  ViconStreamFrameReaders.Empty();
 }
 
 void FLiveLinkViconDataStreamSource::ReceiveClient( ILiveLinkClient* InClient, FGuid InSourceGuid )
 {
   Client = InClient;
   SourceGuid = InSourceGuid;
-  ViconStreamFrameReader = new FViconStreamFrameReader( InClient, ViconStreamProps, SourceGuid );
+  // Each system gets its own reader and threads, as fetching a frame blocks in the SDK
+  for( const ViconStreamProperties& rSystemProps : ViconStreamProps.GetSystems() )
+  {
+    ViconStreamFrameReaders.Add( new FViconStreamFrameReader( InClient, rSystemProps, SourceGuid ) );
+  }
 }
 
 bool FLiveLinkViconDataStreamSource::IsSourceStillValid() const
 {
-  return ViconStreamFrameReader != NULL;
+  return ViconStreamFrameReaders.Num() > 0;
 }
 
 bool FLiveLinkViconDataStreamSource::RequestSourceShutdown()
 {
-  ViconStreamFrameReader->Shutdown();
+  for( FViconStreamFrameReader* pReader : ViconStreamFrameReaders )
+  {
+    pReader->Shutdown();
+  }
   return true;
 }
 
@@ -45,56 +101,129 @@ FText FLiveLinkViconDataStreamSource::GetSourceType() const
 
 FText FLiveLinkViconDataStreamSource::GetSourceMachineName() const
 {
-  if( ViconStreamFrameReader )
+  FString MachineName;
+  for( FViconStreamFrameReader* pReader : ViconStreamFrameReaders )
   {
-    return FText::FromString( ViconStreamFrameReader->ConstructServerAddress() );
-  }
-  else
-  {
-    return FText();
+    if( !MachineName.IsEmpty() )
+    {
+      MachineName += TEXT( ", " );
+    }
+    MachineName += pReader->ConstructServerAddress();
   }
+  return FText::FromString( MachineName );
 }
 
 FText FLiveLinkViconDataStreamSource::GetSourceStatus() const
 {
-  if( !IsConnected() )
+  if( ViconStreamFrameReaders.Num() == 0 )
   {
     return FText::FromString( "Not Connected" );
   }
-  else
+  if( ViconStreamFrameReaders.Num() == 1 )
   {
-    return FText::FromString( "Connected" );
+    return FText::FromString( GetReaderStatus( *ViconStreamFrameReaders[ 0 ] ) );
+  }
+
+  FString Status;
+  double MinSceneTime = TNumericLimits< double >::Max();
+  double MaxSceneTime = TNumericLimits< double >::Lowest();
+  int32 NumTimecoded = 0;
+  for( FViconStreamFrameReader* pReader : ViconStreamFrameReaders )
+  {
+    if( !Status.IsEmpty() )
+    {
+      Status += TEXT( "; " );
+    }
+    const FString& rPrefix = pReader->GetSubjectPrefix();
+    Status += FString::Printf( TEXT( "%s: %s" ), rPrefix.IsEmpty() ? *pReader->ConstructServerAddress() : *rPrefix, *GetReaderStatus( *pReader ) );
+
+    const double SceneTime = pReader->GetStats().LastSceneTimeSeconds;
+    if( pReader->IsConnected() && SceneTime >= 0.0 )
+    {
+      MinSceneTime = FMath::Min( MinSceneTime, SceneTime );
+      MaxSceneTime = FMath::Max( MaxSceneTime, SceneTime );
+      ++NumTimecoded;
+    }
   }
+
+  // Difference between the timecodes of the last frames pushed by each system. This includes the difference
+  // in latency between the systems, so a steady few milliseconds is expected.
+  if( NumTimecoded > 1 )
+  {
+    Status += FString::Printf( TEXT( "; timecode skew %.1f ms" ), ( MaxSceneTime - MinSceneTime ) * 1000.0 );
+  }
+  return FText::FromString( Status );
 }
 
 bool FLiveLinkViconDataStreamSource::IsConnected() const
 {
-  if( ViconStreamFrameReader == nullptr )
+  for( FViconStreamFrameReader* pReader : ViconStreamFrameReaders )
   {
-    return false;
-  }
-  else
-  {
-    return ViconStreamFrameReader->IsConnected();
+    if( pReader->IsConnected() )
+    {
+      return true;
+    }
   }
+  return false;
 }
 
 void FLiveLinkViconDataStreamSource::InitializeSettings( ULiveLinkSourceSettings* Settings )
 {
-  ULiveLinkDataStreamSourceSettings* DataStreamSettings = Cast< ULiveLinkDataStreamSourceSettings >( Settings );
-  ViconStreamFrameReader->SetLightweightEnabled( DataStreamSettings->EnableLightweight );
-  ViconStreamFrameReader->SetMarkerEnabled( DataStreamSettings->StreamMarkerData );
-  ViconStreamFrameReader->SetUnlabeledMarkerEnabled( DataStreamSettings->StreamUnlabeledMarkerData );
-  ViconStreamFrameReader->ShowAllVideoCamera( DataStreamSettings->ShowAllVideoCamera );
+  ApplySettings( Settings );
 }
 
 void FLiveLinkViconDataStreamSource::OnSettingsChanged( ULiveLinkSourceSettings* Settings, const FPropertyChangedEvent& PropertyChangedEvent )
 {
   ULiveLinkDataStreamSourceSettings* DataStreamSettings = Cast< ULiveLinkDataStreamSourceSettings >( Settings );
-
-  ViconStreamFrameReader->SetLightweightEnabled( DataStreamSettings->EnableLightweight );
-  ViconStreamFrameReader->SetMarkerEnabled( DataStreamSettings->StreamMarkerData );
-  ViconStreamFrameReader->SetUnlabeledMarkerEnabled( DataStreamSettings->StreamUnlabeledMarkerData );
-  ViconStreamFrameReader->ShowAllVideoCamera( DataStreamSettings->ShowAllVideoCamera );
+  if( PropertyChangedEvent.GetPropertyName() == GET_MEMBER_NAME_CHECKED( ULiveLinkDataStreamSourceSettings, AlignSystemsByTimecode ) &&
+      ViconStreamFrameReaders.Num() > 1 )
+  {
+    if( !DataStreamSettings->AlignSystemsByTimecode )
+    {
+      DataStreamSettings->Mode = ELiveLinkSourceMode::Latest;
+    }
+    else if( AllSystemsHaveTimecode() )
+    {
+      DataStreamSettings->Mode = ELiveLinkSourceMode::Timecode;
+    }
+    else
+    {
+      // Subjects whose frames carry no timecode would not evaluate in timecode mode
+      UE_LOG( LogViconStream, Warning, TEXT( "Not aligning systems by timecode, not every system is connected and reporting a timecode" ) );
+      DataStreamSettings->AlignSystemsByTimecode = false;
+    }
+  }
+  ApplySettings( Settings );
   ILiveLinkSource::OnSettingsChanged( Settings, PropertyChangedEvent );
 }
+
+bool FLiveLinkViconDataStreamSource::AllSystemsHaveTimecode() const
+{
+  for( FViconStreamFrameReader* pReader : ViconStreamFrameReaders )
+  {
+    if( !pReader->IsConnected() || pReader->GetStats().LastSceneTimeSeconds < 0.0 )
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+void FLiveLinkViconDataStreamSource::ApplySettings( ULiveLinkSourceSettings* Settings )
+{
+  ULiveLinkDataStreamSourceSettings* DataStreamSettings = Cast< ULiveLinkDataStreamSourceSettings >( Settings );
+  for( FViconStreamFrameReader* pReader : ViconStreamFrameReaders )
+  {
+    pReader->SetLightweightEnabled( DataStreamSettings->EnableLightweight );
+    pReader->SetMarkerEnabled( DataStreamSettings->StreamMarkerData );
+    pReader->SetUnlabeledMarkerEnabled( DataStreamSettings->StreamUnlabeledMarkerData );
+    pReader->ShowAllVideoCamera( DataStreamSettings->ShowAllVideoCamera );
+    pReader->SetEventDrivenFrameWait( DataStreamSettings->EventDrivenFrameWait, DataStreamSettings->FrameWaitTimeoutMs );
+    pReader->SetLatestFrameOnly( DataStreamSettings->LatestFrameOnly );
+    pReader->SetComponentSpacePoses( DataStreamSettings->PublishComponentSpacePoses );
+    pReader->SetUnlabeledMarkerTracking( DataStreamSettings->TrackUnlabeledMarkers, DataStreamSettings->UnlabeledMarkerGateDistance );
+    pReader->SetMarkerIndexEnabled( DataStreamSettings->PublishMarkerIndex );
+    pReader->SetSubjectConversionWorkers( DataStreamSettings->SubjectConversionWorkers );
+    pReader->SetSchedulingProfile( ToThreadPriority( DataStreamSettings->ReaderThreadPriority ), DataStreamSettings->ReaderAffinityMask, DataStreamSettings->ReaderDedicatedCore );
+  }
+}
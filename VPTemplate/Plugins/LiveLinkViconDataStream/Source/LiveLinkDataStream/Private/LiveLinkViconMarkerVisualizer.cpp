@@ -5,6 +5,7 @@
 #include "Roles/LiveLinkBasicRole.h"
 #include "LiveLinkViconDataStreamSourceSettings.h"
 #include "LiveLinkViconDataStreamBlueprint.h"
+#include "LiveLinkViconPointCloudRole.h"
 #include "ViconStreamFrameReader.h"
 #include "LiveLinkViconUtils.h"
 
@@ -162,7 +163,7 @@ TArray<FString> ULiveLinkViconMarkerVisualizer::GetSubjectNames() const
   ILiveLinkClient* LiveLinkClient = &ModularFeatures.GetModularFeature<ILiveLinkClient>(ILiveLinkClient::ModularFeatureName);
   for (const FLiveLinkSubjectKey& Subject : LiveLinkClient->GetSubjects(false, false))
   {
-    // Should be a Vicon subject and not a lens
+    // Should be a Vicon subject and not a lens. Marker subjects may carry the prefix of their system.
     const FText ViconSourceType = FText::FromString(FString(ULiveLinkViconDataStreamBlueprint::SOURCE_TYPE.c_str()));
     if (LiveLinkClient->GetSourceType(Subject.Source).EqualTo(ViconSourceType) && 
         !LiveLinkClient->DoesSubjectSupportsRole_AnyThread(Subject.SubjectName, ULiveLinkLensRole::StaticClass()))
@@ -172,12 +173,12 @@ TArray<FString> ULiveLinkViconMarkerVisualizer::GetSubjectNames() const
       {
         if (LiveLinkClient->DoesSubjectSupportsRole_AnyThread(Subject.SubjectName, ULiveLinkTransformRole::StaticClass()) ||
             LiveLinkClient->DoesSubjectSupportsRole_AnyThread(Subject.SubjectName, ULiveLinkAnimationRole::StaticClass()) ||
-            Subject.SubjectName == FViconStreamFrameReader::LABELED_MARKER.c_str())
+            Subject.SubjectName.ToString().EndsWith(FViconStreamFrameReader::LABELED_MARKER.c_str(), ESearchCase::CaseSensitive))
         {
           Names.Emplace(Subject.SubjectName.ToString());
         }
       }
-      if (SourceSettings->StreamUnlabeledMarkerData && Subject.SubjectName == FViconStreamFrameReader::UNLABELED_MARKER.c_str())
+      if (SourceSettings->StreamUnlabeledMarkerData && Subject.SubjectName.ToString().EndsWith(FViconStreamFrameReader::UNLABELED_MARKER.c_str(), ESearchCase::CaseSensitive))
       {
         Names.Emplace(Subject.SubjectName.ToString());
       }
@@ -214,9 +215,20 @@ TArray<FVector> ULiveLinkViconMarkerVisualizer::GetMarkerData() const
     return {};
   }
 
-  // Evaluate frame
+  // Evaluate frame. LabeledMarker and UnlabeledMarker subjects carry their points directly.
   TArray<FVector> MarkerData;
   FLiveLinkSubjectFrameData SubjectFrameData;
+  if (LiveLinkClient->DoesSubjectSupportsRole_AnyThread(SubjectName, ULiveLinkViconPointCloudRole::StaticClass()))
+  {
+    SubjectFrameData.FrameData = FLiveLinkFrameDataStruct(FLiveLinkViconPointCloudFrameData::StaticStruct());
+    SubjectFrameData.StaticData = FLiveLinkStaticDataStruct(FLiveLinkViconPointCloudStaticData::StaticStruct());
+    if (LiveLinkClient->EvaluateFrame_AnyThread(SubjectName, ULiveLinkViconPointCloudRole::StaticClass(), SubjectFrameData))
+    {
+      LiveLinkViconUtils::GetMarkerTranslations(*SubjectFrameData.FrameData.Cast<FLiveLinkViconPointCloudFrameData>(), MarkerData);
+    }
+    return MarkerData;
+  }
+
   SubjectFrameData.FrameData = FLiveLinkFrameDataStruct(FLiveLinkBaseFrameData::StaticStruct());
   SubjectFrameData.StaticData = FLiveLinkStaticDataStruct(FLiveLinkBaseStaticData::StaticStruct());
   if (LiveLinkClient->EvaluateFrame_AnyThread(SubjectName, ULiveLinkBasicRole::StaticClass(), SubjectFrameData))
@@ -0,0 +1,70 @@
+// Copyright (c) 2021 Vicon Motion Systems Ltd. All Rights Reserved.
+
+#include "LiveLinkViconPointCloudRole.h"
+
+#define LOCTEXT_NAMESPACE "LiveLinkViconPointCloudRole"
+
+UScriptStruct* ULiveLinkViconPointCloudRole::GetStaticDataStruct() const
+{
+  return FLiveLinkViconPointCloudStaticData::StaticStruct();
+}
+
+UScriptStruct* ULiveLinkViconPointCloudRole::GetFrameDataStruct() const
+{
+  return FLiveLinkViconPointCloudFrameData::StaticStruct();
+}
+
+UScriptStruct* ULiveLinkViconPointCloudRole::GetBlueprintDataStruct() const
+{
+  return FLiveLinkViconPointCloudBlueprintData::StaticStruct();
+}
+
+bool ULiveLinkViconPointCloudRole::InitializeBlueprintData( const FLiveLinkSubjectFrameData& InSourceData, FLiveLinkBlueprintDataStruct& OutBlueprintData ) const
+{
+  FLiveLinkViconPointCloudBlueprintData* pBlueprintData = OutBlueprintData.Cast< FLiveLinkViconPointCloudBlueprintData >();
+  const FLiveLinkViconPointCloudStaticData* pStaticData = InSourceData.StaticData.Cast< FLiveLinkViconPointCloudStaticData >();
+  const FLiveLinkViconPointCloudFrameData* pFrameData = InSourceData.FrameData.Cast< FLiveLinkViconPointCloudFrameData >();
+  if( !pBlueprintData || !pStaticData || !pFrameData )
+  {
+    return false;
+  }
+
+  GetStaticDataStruct()->CopyScriptStruct( &pBlueprintData->StaticData, pStaticData );
+  GetFrameDataStruct()->CopyScriptStruct( &pBlueprintData->FrameData, pFrameData );
+  return true;
+}
+
+FText ULiveLinkViconPointCloudRole::GetDisplayName() const
+{
+  return LOCTEXT( "PointCloudRole", "Vicon Point Cloud" );
+}
+
+bool ULiveLinkViconPointCloudRole::IsStaticDataValid( const FLiveLinkStaticDataStruct& InStaticData, bool& bOutShouldLogWarning ) const
+{
+  bool bResult = Super::IsStaticDataValid( InStaticData, bOutShouldLogWarning );
+  if( bResult )
+  {
+    const FLiveLinkViconPointCloudStaticData* pStaticData = InStaticData.Cast< FLiveLinkViconPointCloudStaticData >();
+    bResult = pStaticData && pStaticData->Capacity >= 0;
+  }
+  return bResult;
+}
+
+bool ULiveLinkViconPointCloudRole::IsFrameDataValid( const FLiveLinkStaticDataStruct& InStaticData, const FLiveLinkFrameDataStruct& InFrameData, bool& bOutShouldLogWarning ) const
+{
+  bool bResult = Super::IsFrameDataValid( InStaticData, InFrameData, bOutShouldLogWarning );
+  if( bResult )
+  {
+    // Frames pushed before the static data of a new capacity has been applied are dropped
+    const FLiveLinkViconPointCloudStaticData* pStaticData = InStaticData.Cast< FLiveLinkViconPointCloudStaticData >();
+    const FLiveLinkViconPointCloudFrameData* pFrameData = InFrameData.Cast< FLiveLinkViconPointCloudFrameData >();
+    bResult = pStaticData && pFrameData &&
+              pFrameData->Points.Num() == pStaticData->Capacity &&
+              pFrameData->Valid.Num() == pStaticData->Capacity &&
+              ( pFrameData->Ids.Num() == 0 || pFrameData->Ids.Num() == pStaticData->Capacity ) &&
+              pFrameData->MarkerCount <= pStaticData->Capacity;
+  }
+  return bResult;
+}
+
+#undef LOCTEXT_NAMESPACE
@@ -1,4 +1,5 @@
 #include "LiveLinkViconUtils.h"
+#include "LiveLinkViconPointCloudRole.h"
 
 namespace LiveLinkViconUtils
 {
@@ -7,12 +8,19 @@ bool GetMarkerTranslations(const TArray<float> & PropertyValues, TArray<FVector>
 {
   // Markers are in the format [n, x1, y1, z1 ... xn, yn, zn, 0, 0, 0 ... , 0, 0, 0]
   MarkerData.Empty();
-  if ((PropertyValues.Num() - 1 )% 3 != 0)
+  if (PropertyValues.Num() < 1 || (PropertyValues.Num() - 1) % 3 != 0)
   {
-    UE_LOG(LogLiveLinkViconUtils, Log, TEXT("Cannot get marker translations, property values are in invalid format"));
+    UE_LOG(LogLiveLinkViconUtils, Log, TEXT("Cannot get marker translations, property values are in invalid format. "
+                                            "Use Get Point Cloud Translations for the LabeledMarker and UnlabeledMarker subjects."));
+    return false;
+  }
+  const unsigned int NumMarkers = static_cast<unsigned int>(FMath::Max(PropertyValues[0], 0.0f));
+  if (PropertyValues.Num() < 1 + 3 * static_cast<int64>(NumMarkers))
+  {
+    UE_LOG(LogLiveLinkViconUtils, Log, TEXT("Cannot get marker translations, property values hold fewer than the %u markers counted. "
+                                            "Use Get Point Cloud Translations for the LabeledMarker and UnlabeledMarker subjects."), NumMarkers);
     return false;
   }
-  const unsigned int NumMarkers = static_cast<unsigned int>(PropertyValues[0]);
   for (unsigned int i = 0; i < NumMarkers; i = i + 1)
   {
     MarkerData.Emplace(FVector(PropertyValues[i * 3 + 1], PropertyValues[i * 3 + 2], PropertyValues[i * 3 + 3]));
@@ -20,4 +28,22 @@ bool GetMarkerTranslations(const TArray<float> & PropertyValues, TArray<FVector>
   return true;
 }
 
+bool GetMarkerTranslations(const FLiveLinkViconPointCloudFrameData& PointCloud, TArray<FVector>& MarkerData)
+{
+  MarkerData.Reset(PointCloud.MarkerCount);
+  if (PointCloud.Valid.Num() != PointCloud.Points.Num())
+  {
+    UE_LOG(LogLiveLinkViconUtils, Log, TEXT("Cannot get marker translations, point cloud has no validity for every point"));
+    return false;
+  }
+  for (int32 PointIndex = 0; PointIndex < PointCloud.Points.Num(); ++PointIndex)
+  {
+    if (PointCloud.Valid[PointIndex])
+    {
+      MarkerData.Emplace(FVector(PointCloud.Points[PointIndex]));
+    }
+  }
+  return true;
+}
+
 }
@@ -0,0 +1,423 @@
+// Copyright (c) 2021 Vicon Motion Systems Ltd. All Rights Reserved.
+
+// =========================================================================
+// Microbenchmarks of the frame conversion paths, run from the console.
+//
+// Each benchmark runs on synthetic data, so no server is needed, and logs
+// its results to LogViconStream.
+// =========================================================================
+
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "Math/RandomStream.h"
+#include "ViconMarkerIndex.h"
+#include "ViconPoseKernel.h"
+#include "ViconStream.h"
+
+namespace
+{
+  static const int32 s_DefaultBenchmarkBones = 1000000;
+  static const int32 s_BenchmarkBonesPerSubject = 50;
+  static const int32 s_DefaultBenchmarkMarkers = 5000;
+  // Ten seconds of frames at 240 Hz
+  static const int32 s_BenchmarkMarkerFrames = 2400;
+  // One second of frames at 240 Hz, each queried by as many actors
+  static const int32 s_BenchmarkQueryFrames = 240;
+  static const int32 s_DefaultBenchmarkQueries = 100;
+  // Radius of the radius queries, about the size of a prop, in cm
+  static const float s_BenchmarkQueryRadius = 10.0f;
+
+  // Time i_rFunction, which converts i_NumBones bones, and log the throughput
+  template< typename FunctionType >
+  double TimeBones( const TCHAR* i_pLabel, int32 i_NumBones, FunctionType&& i_rFunction )
+  {
+    const double Start = FPlatformTime::Seconds();
+    i_rFunction();
+    const double Seconds = FPlatformTime::Seconds() - Start;
+    UE_LOG( LogViconStream, Display, TEXT( "  %-10s %8.2f ms per million bones (%.1f M bones/s)" ),
+            i_pLabel, Seconds * 1000.0 * 1000000.0 / i_NumBones, i_NumBones / Seconds / 1000000.0 );
+    return Seconds;
+  }
+
+  void MakeBenchmarkSegments( int32 i_NumBones, TArray< FViconRawSegment >& o_rSegments, TArray< FVector >& o_rHierarchyScales )
+  {
+    FRandomStream Random( 0x1C0 );
+    o_rSegments.SetNumUninitialized( i_NumBones );
+    o_rHierarchyScales.SetNumUninitialized( i_NumBones );
+    for( int32 BoneIndex = 0; BoneIndex < i_NumBones; ++BoneIndex )
+    {
+      FViconRawSegment& rSegment = o_rSegments[ BoneIndex ];
+      const FVector Translation = Random.GetUnitVector() * Random.FRandRange( 10.0, 500.0 );
+      const FQuat Rotation = FQuat( Random.GetUnitVector(), Random.FRandRange( -PI, PI ) );
+      rSegment.Translation[ 0 ] = Translation.X;
+      rSegment.Translation[ 1 ] = Translation.Y;
+      rSegment.Translation[ 2 ] = Translation.Z;
+      rSegment.Rotation[ 0 ] = Rotation.X;
+      rSegment.Rotation[ 1 ] = Rotation.Y;
+      rSegment.Rotation[ 2 ] = Rotation.Z;
+      rSegment.Rotation[ 3 ] = Rotation.W;
+      rSegment.StaticScale[ 0 ] = rSegment.StaticScale[ 1 ] = rSegment.StaticScale[ 2 ] = Random.FRandRange( 0.9, 1.1 );
+      rSegment.bTranslationValid = true;
+      rSegment.bRotationValid = true;
+      rSegment.bHasStaticScale = true;
+      o_rHierarchyScales[ BoneIndex ] = ( BoneIndex % s_BenchmarkBonesPerSubject == 0 ) ? FVector::OneVector : FVector( Random.FRandRange( 0.8, 1.2 ) );
+    }
+  }
+
+  // The per bone conversion the kernel replaced, kept as the baseline
+  void ConvertSegmentsPerBone( TArrayView< const FViconRawSegment > i_Segments, const FVector* i_pHierarchyScales, bool i_bYUp, TArrayView< FTransform > o_Poses )
+  {
+    for( int32 BoneIndex = 0; BoneIndex < i_Segments.Num(); ++BoneIndex )
+    {
+      const FViconRawSegment& rSegment = i_Segments[ BoneIndex ];
+      FTransform& rPose = o_Poses[ BoneIndex ];
+      rPose.SetScale3D( FVector( rSegment.StaticScale[ 0 ], rSegment.StaticScale[ 1 ], rSegment.StaticScale[ 2 ] ) );
+
+      const FVector Translation = FVector( rSegment.Translation[ 0 ], -rSegment.Translation[ 1 ], rSegment.Translation[ 2 ] ) * 0.1;
+      FVector ScaledTranslation;
+      for( int32 i = 0; i < 3; ++i )
+      {
+        ScaledTranslation[ i ] = i_pHierarchyScales[ BoneIndex ][ i ] != 0 ? Translation[ i ] / i_pHierarchyScales[ BoneIndex ][ i ] : Translation[ i ];
+      }
+      rPose.SetTranslation( ScaledTranslation );
+      rPose.SetRotation( FQuat( -rSegment.Rotation[ 0 ], rSegment.Rotation[ 1 ], -rSegment.Rotation[ 2 ], rSegment.Rotation[ 3 ] ) );
+    }
+    if( i_bYUp && i_Segments.Num() > 0 )
+    {
+      o_Poses[ 0 ] = o_Poses[ 0 ] * FViconPoseKernel::YUpRotation;
+    }
+  }
+
+  void BenchmarkPoseKernel( const TArray< FString >& i_rArgs )
+  {
+    const int32 RequestedBones = i_rArgs.Num() > 0 ? FMath::Max( FCString::Atoi( *i_rArgs[ 0 ] ), s_BenchmarkBonesPerSubject ) : s_DefaultBenchmarkBones;
+    const int32 NumSubjects = RequestedBones / s_BenchmarkBonesPerSubject;
+    const int32 NumBones = NumSubjects * s_BenchmarkBonesPerSubject;
+
+    TArray< FViconRawSegment > Segments;
+    TArray< FVector > HierarchyScales;
+    MakeBenchmarkSegments( NumBones, Segments, HierarchyScales );
+    TArray< FTransform > PerBonePoses;
+    TArray< FTransform > KernelPoses;
+    PerBonePoses.SetNum( NumBones );
+    KernelPoses.SetNum( NumBones );
+
+    UE_LOG( LogViconStream, Display, TEXT( "Segment pose conversion, %d bones in subjects of %d bones:" ), NumBones, s_BenchmarkBonesPerSubject );
+    const double PerBoneSeconds = TimeBones( TEXT( "Per bone" ), NumBones, [ & ]()
+    {
+      for( int32 SubjectIndex = 0; SubjectIndex < NumSubjects; ++SubjectIndex )
+      {
+        const int32 First = SubjectIndex * s_BenchmarkBonesPerSubject;
+        ConvertSegmentsPerBone( MakeArrayView( &Segments[ First ], s_BenchmarkBonesPerSubject ), &HierarchyScales[ First ], true,
+                                MakeArrayView( &PerBonePoses[ First ], s_BenchmarkBonesPerSubject ) );
+      }
+    } );
+    const FViconPoseKernel::FSegmentConverter Converter = FViconPoseKernel::SelectSegmentConverters( true ).Skeleton[ 1 ];
+    const double KernelSeconds = TimeBones( TEXT( "Kernel" ), NumBones, [ & ]()
+    {
+      for( int32 SubjectIndex = 0; SubjectIndex < NumSubjects; ++SubjectIndex )
+      {
+        const int32 First = SubjectIndex * s_BenchmarkBonesPerSubject;
+        Converter( MakeArrayView( &Segments[ First ], s_BenchmarkBonesPerSubject ), &HierarchyScales[ First ], nullptr,
+                   MakeArrayView( &KernelPoses[ First ], s_BenchmarkBonesPerSubject ) );
+      }
+    } );
+
+    int32 Mismatches = 0;
+    for( int32 BoneIndex = 0; BoneIndex < NumBones; ++BoneIndex )
+    {
+      if( !PerBonePoses[ BoneIndex ].Equals( KernelPoses[ BoneIndex ], 1.e-6 ) )
+      {
+        ++Mismatches;
+      }
+    }
+    UE_LOG( LogViconStream, Display, TEXT( "  Speedup %.2fx, %d mismatched poses" ), PerBoneSeconds / KernelSeconds, Mismatches );
+  }
+
+  // The per marker conversion the marker converters replaced: an FTransform composed for each marker, with the axis mapping tested for each
+  void ConvertMarkersGeneric( const double* i_pTranslations, int32 i_NumMarkers, bool i_bYUp, float* o_pMarkers )
+  {
+    for( int32 MarkerIndex = 0; MarkerIndex < i_NumMarkers; ++MarkerIndex )
+    {
+      const double* pIn = i_pTranslations + MarkerIndex * 3;
+      FTransform MarkerTransformation( FVector( pIn[ 0 ], -pIn[ 1 ], pIn[ 2 ] ) * 0.1 );
+      if( i_bYUp )
+      {
+        MarkerTransformation = MarkerTransformation * FViconPoseKernel::YUpRotation;
+      }
+      const FVector Marker = MarkerTransformation.GetTranslation();
+      o_pMarkers[ MarkerIndex * 3 ] = Marker.X;
+      o_pMarkers[ MarkerIndex * 3 + 1 ] = Marker.Y;
+      o_pMarkers[ MarkerIndex * 3 + 2 ] = Marker.Z;
+    }
+  }
+
+  // Time the per bone and specialised conversion of i_NumSubjects subjects of i_BonesPerSubject bones
+  void BenchmarkSegmentConverter( const TCHAR* i_pLabel, const TArray< FViconRawSegment >& i_rSegments, const TArray< FVector >& i_rHierarchyScales,
+                                  int32 i_BonesPerSubject, FViconPoseKernel::FSegmentConverter i_Converter )
+  {
+    const int32 NumSubjects = i_rSegments.Num() / i_BonesPerSubject;
+    const int32 NumBones = NumSubjects * i_BonesPerSubject;
+    TArray< FTransform > PerBonePoses;
+    TArray< FTransform > SpecialisedPoses;
+    PerBonePoses.SetNum( NumBones );
+    SpecialisedPoses.SetNum( NumBones );
+
+    UE_LOG( LogViconStream, Display, TEXT( "%s, %d subjects of %d bones, scaled, Y up:" ), i_pLabel, NumSubjects, i_BonesPerSubject );
+    const double PerBoneSeconds = TimeBones( TEXT( "Per bone" ), NumBones, [ & ]()
+    {
+      for( int32 SubjectIndex = 0; SubjectIndex < NumSubjects; ++SubjectIndex )
+      {
+        const int32 First = SubjectIndex * i_BonesPerSubject;
+        ConvertSegmentsPerBone( MakeArrayView( &i_rSegments[ First ], i_BonesPerSubject ), &i_rHierarchyScales[ First ], true,
+                                MakeArrayView( &PerBonePoses[ First ], i_BonesPerSubject ) );
+      }
+    } );
+    const double SpecialisedSeconds = TimeBones( TEXT( "Specialised" ), NumBones, [ & ]()
+    {
+      for( int32 SubjectIndex = 0; SubjectIndex < NumSubjects; ++SubjectIndex )
+      {
+        const int32 First = SubjectIndex * i_BonesPerSubject;
+        i_Converter( MakeArrayView( &i_rSegments[ First ], i_BonesPerSubject ), &i_rHierarchyScales[ First ], nullptr,
+                     MakeArrayView( &SpecialisedPoses[ First ], i_BonesPerSubject ) );
+      }
+    } );
+
+    int32 Mismatches = 0;
+    for( int32 BoneIndex = 0; BoneIndex < NumBones; ++BoneIndex )
+    {
+      if( !PerBonePoses[ BoneIndex ].Equals( SpecialisedPoses[ BoneIndex ], 1.e-6 ) )
+      {
+        ++Mismatches;
+      }
+    }
+    UE_LOG( LogViconStream, Display, TEXT( "  Speedup %.2fx, %d mismatched poses" ), PerBoneSeconds / SpecialisedSeconds, Mismatches );
+  }
+
+  void BenchmarkConversionPaths( const TArray< FString >& i_rArgs )
+  {
+    const int32 NumBones = i_rArgs.Num() > 0 ? FMath::Max( FCString::Atoi( *i_rArgs[ 0 ] ), s_BenchmarkBonesPerSubject ) : s_DefaultBenchmarkBones;
+
+    TArray< FViconRawSegment > Segments;
+    TArray< FVector > HierarchyScales;
+    MakeBenchmarkSegments( NumBones, Segments, HierarchyScales );
+    const FViconPoseKernel::FSegmentConverters Converters = FViconPoseKernel::SelectSegmentConverters( true );
+    BenchmarkSegmentConverter( TEXT( "Skeletons" ), Segments, HierarchyScales, s_BenchmarkBonesPerSubject, Converters.Skeleton[ 1 ] );
+    // Roots, which are what rigid bodies consist of, have a hierarchy scale of one
+    for( FVector& rHierarchyScale : HierarchyScales )
+    {
+      rHierarchyScale = FVector::OneVector;
+    }
+    BenchmarkSegmentConverter( TEXT( "Rigid bodies" ), Segments, HierarchyScales, 1, Converters.RigidBody[ 1 ] );
+
+    // Reuse the segment translations as marker translations
+    TArray< double > Translations;
+    Translations.SetNumUninitialized( NumBones * 3 );
+    for( int32 MarkerIndex = 0; MarkerIndex < NumBones; ++MarkerIndex )
+    {
+      FMemory::Memcpy( &Translations[ MarkerIndex * 3 ], Segments[ MarkerIndex ].Translation, sizeof( Segments[ MarkerIndex ].Translation ) );
+    }
+    TArray< float > GenericMarkers;
+    TArray< float > SpecialisedMarkers;
+    GenericMarkers.SetNumUninitialized( NumBones * 3 );
+    SpecialisedMarkers.SetNumUninitialized( NumBones * 3 );
+
+    UE_LOG( LogViconStream, Display, TEXT( "Markers, %d markers, Y up:" ), NumBones );
+    const double GenericSeconds = TimeBones( TEXT( "Generic" ), NumBones, [ & ]()
+    {
+      ConvertMarkersGeneric( Translations.GetData(), NumBones, true, GenericMarkers.GetData() );
+    } );
+    const double SpecialisedSeconds = TimeBones( TEXT( "Specialised" ), NumBones, [ & ]()
+    {
+      FViconPoseKernel::SelectMarkerConverter( true )( Translations.GetData(), NumBones, SpecialisedMarkers.GetData() );
+    } );
+
+    int32 Mismatches = 0;
+    for( int32 ValueIndex = 0; ValueIndex < NumBones * 3; ++ValueIndex )
+    {
+      if( !FMath::IsNearlyEqual( GenericMarkers[ ValueIndex ], SpecialisedMarkers[ ValueIndex ], 1.e-3f ) )
+      {
+        ++Mismatches;
+      }
+    }
+    UE_LOG( LogViconStream, Display, TEXT( "  Speedup %.2fx, %d mismatched values" ), GenericSeconds / SpecialisedSeconds, Mismatches );
+  }
+
+  // Time i_rFunction, which converts i_NumFrames frames of i_NumMarkers markers, and log the time per frame
+  template< typename FunctionType >
+  double TimeMarkerFrames( const TCHAR* i_pLabel, int32 i_NumMarkers, int32 i_NumFrames, FunctionType&& i_rFunction )
+  {
+    const double Start = FPlatformTime::Seconds();
+    i_rFunction();
+    const double Seconds = FPlatformTime::Seconds() - Start;
+    UE_LOG( LogViconStream, Display, TEXT( "  %-10s %8.4f ms per frame (%.1f M markers/s)" ),
+            i_pLabel, Seconds * 1000.0 / i_NumFrames, static_cast< double >( i_NumMarkers ) * i_NumFrames / Seconds / 1000000.0 );
+    return Seconds;
+  }
+
+  void BenchmarkMarkerBatch( const TArray< FString >& i_rArgs )
+  {
+    const int32 NumMarkers = i_rArgs.Num() > 0 ? FMath::Max( FCString::Atoi( *i_rArgs[ 0 ] ), 1 ) : s_DefaultBenchmarkMarkers;
+
+    FRandomStream Random( 0x1C1 );
+    TArray< double > Translations;
+    Translations.SetNumUninitialized( NumMarkers * 3 );
+    for( int32 MarkerIndex = 0; MarkerIndex < NumMarkers; ++MarkerIndex )
+    {
+      const FVector Translation = Random.GetUnitVector() * Random.FRandRange( 10.0, 5000.0 );
+      Translations[ MarkerIndex * 3 ] = Translation.X;
+      Translations[ MarkerIndex * 3 + 1 ] = Translation.Y;
+      Translations[ MarkerIndex * 3 + 2 ] = Translation.Z;
+    }
+    TArray< float > PerMarkerValues;
+    TArray< float > BatchValues;
+    PerMarkerValues.SetNumUninitialized( NumMarkers * 3 );
+    BatchValues.SetNumUninitialized( NumMarkers * 3 );
+
+    for( const bool bYUp : { false, true } )
+    {
+      UE_LOG( LogViconStream, Display, TEXT( "Marker frames of %d markers, %s:" ), NumMarkers, bYUp ? TEXT( "Y up" ) : TEXT( "Z up" ) );
+      const double PerMarkerSeconds = TimeMarkerFrames( TEXT( "Per marker" ), NumMarkers, s_BenchmarkMarkerFrames, [ & ]()
+      {
+        for( int32 Frame = 0; Frame < s_BenchmarkMarkerFrames; ++Frame )
+        {
+          ConvertMarkersGeneric( Translations.GetData(), NumMarkers, bYUp, PerMarkerValues.GetData() );
+        }
+      } );
+      const FMatrix MarkerMatrix = FViconPoseKernel::MakeMarkerMatrix( bYUp );
+      const double BatchSeconds = TimeMarkerFrames( TEXT( "Batch" ), NumMarkers, s_BenchmarkMarkerFrames, [ & ]()
+      {
+        for( int32 Frame = 0; Frame < s_BenchmarkMarkerFrames; ++Frame )
+        {
+          FViconPoseKernel::ConvertMarkerBatch( Translations.GetData(), NumMarkers, MarkerMatrix, BatchValues.GetData() );
+        }
+      } );
+
+      int32 Mismatches = 0;
+      for( int32 ValueIndex = 0; ValueIndex < NumMarkers * 3; ++ValueIndex )
+      {
+        if( !FMath::IsNearlyEqual( PerMarkerValues[ ValueIndex ], BatchValues[ ValueIndex ], 1.e-3f ) )
+        {
+          ++Mismatches;
+        }
+      }
+      UE_LOG( LogViconStream, Display, TEXT( "  Speedup %.2fx, %d mismatched values" ), PerMarkerSeconds / BatchSeconds, Mismatches );
+    }
+  }
+
+  void BenchmarkMarkerQueries( const TArray< FString >& i_rArgs )
+  {
+    const int32 NumMarkers = i_rArgs.Num() > 0 ? FMath::Max( FCString::Atoi( *i_rArgs[ 0 ] ), 1 ) : s_DefaultBenchmarkMarkers;
+    const int32 NumQueries = i_rArgs.Num() > 1 ? FMath::Max( FCString::Atoi( *i_rArgs[ 1 ] ), 1 ) : s_DefaultBenchmarkQueries;
+
+    // Markers and query locations spread over a 10 m x 10 m x 2 m capture volume
+    FRandomStream Random( 0x1C2 );
+    const FVector3f Volume( 1000.0f, 1000.0f, 200.0f );
+    auto RandomLocation = [ & ]()
+    {
+      return FVector3f( Random.FRand() * Volume.X - Volume.X * 0.5f, Random.FRand() * Volume.Y - Volume.Y * 0.5f, Random.FRand() * Volume.Z );
+    };
+    TArray< FVector3f > Points;
+    TArray< FVector3f > Queries;
+    for( int32 MarkerIndex = 0; MarkerIndex < NumMarkers; ++MarkerIndex )
+    {
+      Points.Add( RandomLocation() );
+    }
+    for( int32 QueryIndex = 0; QueryIndex < NumQueries; ++QueryIndex )
+    {
+      Queries.Add( RandomLocation() );
+    }
+    // Half the markers labeled, half unlabeled
+    const int32 NumLabeled = NumMarkers / 2;
+    const TArrayView< const FVector3f > Labeled( Points.GetData(), NumLabeled );
+    const TArrayView< const FVector3f > Unlabeled( Points.GetData() + NumLabeled, NumMarkers - NumLabeled );
+
+    // The nearest marker to each query, and the markers within the radius, found by each method
+    TArray< float > LinearNearest;
+    TArray< float > IndexNearest;
+    LinearNearest.SetNumUninitialized( NumQueries );
+    IndexNearest.SetNumUninitialized( NumQueries );
+    int64 LinearInRadius = 0;
+    int64 IndexInRadius = 0;
+
+    UE_LOG( LogViconStream, Display, TEXT( "Marker queries, %d markers, %d nearest and %d radius queries per frame:" ), NumMarkers, NumQueries, NumQueries );
+    const double LinearSeconds = TimeMarkerFrames( TEXT( "Linear" ), NumMarkers, s_BenchmarkQueryFrames, [ & ]()
+    {
+      TArray< int32 > Found;
+      for( int32 Frame = 0; Frame < s_BenchmarkQueryFrames; ++Frame )
+      {
+        LinearInRadius = 0;
+        for( int32 QueryIndex = 0; QueryIndex < NumQueries; ++QueryIndex )
+        {
+          const FVector3f& rQuery = Queries[ QueryIndex ];
+          float BestDistanceSquared = UE_MAX_FLT;
+          Found.Reset();
+          for( int32 MarkerIndex = 0; MarkerIndex < NumMarkers; ++MarkerIndex )
+          {
+            const float DistanceSquared = FVector3f::DistSquared( rQuery, Points[ MarkerIndex ] );
+            BestDistanceSquared = FMath::Min( BestDistanceSquared, DistanceSquared );
+            if( DistanceSquared <= FMath::Square( s_BenchmarkQueryRadius ) )
+            {
+              Found.Add( MarkerIndex );
+            }
+          }
+          LinearNearest[ QueryIndex ] = FMath::Sqrt( BestDistanceSquared );
+          LinearInRadius += Found.Num();
+        }
+      }
+    } );
+    // Each frame builds the index, as the conversion thread does, before querying it
+    FViconMarkerIndex Index;
+    const double IndexSeconds = TimeMarkerFrames( TEXT( "Index" ), NumMarkers, s_BenchmarkQueryFrames, [ & ]()
+    {
+      TArray< int32 > Found;
+      for( int32 Frame = 0; Frame < s_BenchmarkQueryFrames; ++Frame )
+      {
+        Index.Reset( Frame );
+        Index.AddSubject( TEXT( "LabeledMarker" ), Labeled, TArrayView< const int32 >() );
+        Index.AddSubject( TEXT( "UnlabeledMarker" ), Unlabeled, TArrayView< const int32 >() );
+        Index.Build();
+        IndexInRadius = 0;
+        for( int32 QueryIndex = 0; QueryIndex < NumQueries; ++QueryIndex )
+        {
+          const FVector3f& rQuery = Queries[ QueryIndex ];
+          const int32 Nearest = Index.FindNearest( rQuery, UE_MAX_FLT );
+          IndexNearest[ QueryIndex ] = Nearest != INDEX_NONE ? FVector3f::Dist( rQuery, Index.GetMarker( Nearest ).Position ) : UE_MAX_FLT;
+          Found.Reset();
+          Index.FindInRadius( rQuery, s_BenchmarkQueryRadius, Found );
+          IndexInRadius += Found.Num();
+        }
+      }
+    } );
+
+    int32 Mismatches = LinearInRadius == IndexInRadius ? 0 : 1;
+    for( int32 QueryIndex = 0; QueryIndex < NumQueries; ++QueryIndex )
+    {
+      if( !FMath::IsNearlyEqual( LinearNearest[ QueryIndex ], IndexNearest[ QueryIndex ], 1.e-3f ) )
+      {
+        ++Mismatches;
+      }
+    }
+    UE_LOG( LogViconStream, Display, TEXT( "  Speedup %.2fx, %d mismatched results" ), LinearSeconds / IndexSeconds, Mismatches );
+  }
+
+  static FAutoConsoleCommand s_BenchmarkPoseKernelCommand(
+    TEXT( "ViconDataStream.Benchmark.PoseKernel" ),
+    TEXT( "Time the segment pose conversion kernel against per bone conversion. Optional argument: number of bones (default 1000000)." ),
+    FConsoleCommandWithArgsDelegate::CreateStatic( &BenchmarkPoseKernel ) );
+
+  static FAutoConsoleCommand s_BenchmarkConversionPathsCommand(
+    TEXT( "ViconDataStream.Benchmark.ConversionPaths" ),
+    TEXT( "Time the per bone conversion of skeletons and rigid bodies, and the generic conversion of markers, against the specialised converters. Optional argument: number of bones (default 1000000)." ),
+    FConsoleCommandWithArgsDelegate::CreateStatic( &BenchmarkConversionPaths ) );
+
+  static FAutoConsoleCommand s_BenchmarkMarkerBatchCommand(
+    TEXT( "ViconDataStream.Benchmark.MarkerBatch" ),
+    TEXT( "Time the batch marker conversion against per marker FTransform composition. Optional argument: markers per frame (default 5000)." ),
+    FConsoleCommandWithArgsDelegate::CreateStatic( &BenchmarkMarkerBatch ) );
+
+  static FAutoConsoleCommand s_BenchmarkMarkerQueriesCommand(
+    TEXT( "ViconDataStream.Benchmark.MarkerQueries" ),
+    TEXT( "Time building the marker index and querying it against a linear search of the markers. Optional arguments: markers per frame (default 5000), queries per frame (default 100)." ),
+    FConsoleCommandWithArgsDelegate::CreateStatic( &BenchmarkMarkerQueries ) );
+}
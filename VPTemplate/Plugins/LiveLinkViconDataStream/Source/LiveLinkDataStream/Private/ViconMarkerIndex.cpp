@@ -0,0 +1,288 @@
+// Copyright (c) 2021 Vicon Motion Systems Ltd. All Rights Reserved.
+
+#include "ViconMarkerIndex.h"
+#include "Misc/ScopeLock.h"
+
+namespace
+{
+  // Markers per cell the grid is sized for, and the most cells it may have per marker when the markers
+  // lie in a plane or a line
+  const float s_MarkersPerCell = 2.0f;
+  const int32 s_MaxCellsPerMarker = 2;
+  // Smallest extent of the grid along each axis, in cm
+  const float s_MinGridExtent = 1.0f;
+
+  // Cell coordinate of i_Value along an axis of i_Dimension cells, clamped to the grid. Clamping before
+  // converting to an integer keeps far away and non finite values from overflowing.
+  FORCEINLINE int32 ClampedCell( float i_Value, int32 i_Dimension )
+  {
+    return FMath::FloorToInt32( FMath::Clamp( i_Value, 0.0f, static_cast< float >( i_Dimension - 1 ) ) );
+  }
+
+  FCriticalSection& RegistryLock()
+  {
+    static FCriticalSection s_Lock;
+    return s_Lock;
+  }
+
+  TMap< const void*, FViconMarkerIndexPtr >& PublishedIndices()
+  {
+    static TMap< const void*, FViconMarkerIndexPtr > s_Indices;
+    return s_Indices;
+  }
+}
+
+void FViconMarkerIndex::Reset( uint32 i_FrameNumber )
+{
+  m_FrameNumber = i_FrameNumber;
+  m_SubjectNames.Reset();
+  m_Unsorted.Reset();
+}
+
+void FViconMarkerIndex::AddSubject( FName i_SubjectName, TArrayView< const FVector3f > i_Points, TArrayView< const int32 > i_Ids )
+{
+  const int32 Subject = m_SubjectNames.Add( i_SubjectName );
+  const bool bHasIds = i_Ids.Num() >= i_Points.Num();
+  m_Unsorted.Reserve( m_Unsorted.Num() + i_Points.Num() );
+  for( int32 PointIndex = 0; PointIndex < i_Points.Num(); ++PointIndex )
+  {
+    FMarker& rMarker = m_Unsorted.AddDefaulted_GetRef();
+    rMarker.Position = i_Points[ PointIndex ];
+    rMarker.PointIndex = PointIndex;
+    rMarker.Id = bHasIds ? i_Ids[ PointIndex ] : INDEX_NONE;
+    rMarker.Subject = Subject;
+  }
+}
+
+void FViconMarkerIndex::Build()
+{
+  const int32 NumMarkers = m_Unsorted.Num();
+  if( NumMarkers == 0 )
+  {
+    m_Markers.Reset();
+    m_CellStarts.Reset();
+    m_Dimensions = FIntVector::ZeroValue;
+    return;
+  }
+
+  FVector3f Min = m_Unsorted[ 0 ].Position;
+  FVector3f Max = Min;
+  for( const FMarker& rMarker : m_Unsorted )
+  {
+    Min = FVector3f::Min( Min, rMarker.Position );
+    Max = FVector3f::Max( Max, rMarker.Position );
+  }
+  const FVector3f Extent = FVector3f::Max( Max - Min, FVector3f( s_MinGridExtent ) );
+
+  // Cells for about s_MarkersPerCell markers each if the markers filled the bounds. Grow the cells until there
+  // are not too many of them, which is only needed when the markers are flat along an axis.
+  const int32 MaxCells = FMath::Max( NumMarkers * s_MaxCellsPerMarker, 1 );
+  float CellSize = FMath::Pow( Extent.X * Extent.Y * Extent.Z * s_MarkersPerCell / NumMarkers, 1.0f / 3.0f );
+  for( ;; )
+  {
+    m_Dimensions = FIntVector( FMath::Max( FMath::CeilToInt32( Extent.X / CellSize ), 1 ),
+                               FMath::Max( FMath::CeilToInt32( Extent.Y / CellSize ), 1 ),
+                               FMath::Max( FMath::CeilToInt32( Extent.Z / CellSize ), 1 ) );
+    if( static_cast< int64 >( m_Dimensions.X ) * m_Dimensions.Y * m_Dimensions.Z <= MaxCells )
+    {
+      break;
+    }
+    CellSize *= 1.26f;
+  }
+  m_Origin = Min;
+  m_CellSize = CellSize;
+  m_InvCellSize = 1.0f / CellSize;
+  const int32 NumCells = m_Dimensions.X * m_Dimensions.Y * m_Dimensions.Z;
+
+  // Counting sort of the markers by cell
+  m_MarkerCells.SetNumUninitialized( NumMarkers, false );
+  m_CellStarts.Init( 0, NumCells + 1 );
+  for( int32 MarkerIndex = 0; MarkerIndex < NumMarkers; ++MarkerIndex )
+  {
+    const FIntVector Cell = CellOf( m_Unsorted[ MarkerIndex ].Position );
+    const int32 Index = CellIndex( Cell.X, Cell.Y, Cell.Z );
+    m_MarkerCells[ MarkerIndex ] = Index;
+    ++m_CellStarts[ Index + 1 ];
+  }
+  for( int32 Index = 0; Index < NumCells; ++Index )
+  {
+    m_CellStarts[ Index + 1 ] += m_CellStarts[ Index ];
+  }
+  // Placing the markers advances each cell's start to the start of the next cell, so shift them back after
+  m_Markers.SetNumUninitialized( NumMarkers, false );
+  for( int32 MarkerIndex = 0; MarkerIndex < NumMarkers; ++MarkerIndex )
+  {
+    m_Markers[ m_CellStarts[ m_MarkerCells[ MarkerIndex ] ]++ ] = m_Unsorted[ MarkerIndex ];
+  }
+  for( int32 Index = NumCells; Index > 0; --Index )
+  {
+    m_CellStarts[ Index ] = m_CellStarts[ Index - 1 ];
+  }
+  m_CellStarts[ 0 ] = 0;
+}
+
+FIntVector FViconMarkerIndex::CellOf( const FVector3f& i_rPosition ) const
+{
+  const FVector3f Scaled = ( i_rPosition - m_Origin ) * m_InvCellSize;
+  return FIntVector( ClampedCell( Scaled.X, m_Dimensions.X ), ClampedCell( Scaled.Y, m_Dimensions.Y ), ClampedCell( Scaled.Z, m_Dimensions.Z ) );
+}
+
+bool FViconMarkerIndex::CellRange( const FVector3f& i_rMin, const FVector3f& i_rMax, FIntVector& o_rMinCell, FIntVector& o_rMaxCell ) const
+{
+  if( m_Markers.Num() == 0 )
+  {
+    return false;
+  }
+  const FVector3f GridMax = m_Origin + FVector3f( m_Dimensions ) * m_CellSize;
+  if( i_rMax.X < m_Origin.X || i_rMax.Y < m_Origin.Y || i_rMax.Z < m_Origin.Z ||
+      i_rMin.X > GridMax.X || i_rMin.Y > GridMax.Y || i_rMin.Z > GridMax.Z )
+  {
+    return false;
+  }
+  o_rMinCell = CellOf( i_rMin );
+  o_rMaxCell = CellOf( i_rMax );
+  return true;
+}
+
+int32 FViconMarkerIndex::FindNearest( const FVector3f& i_rLocation, float i_MaxDistance ) const
+{
+  if( m_Markers.Num() == 0 || i_MaxDistance < 0.0f )
+  {
+    return INDEX_NONE;
+  }
+
+  int32 BestMarker = INDEX_NONE;
+  float BestDistanceSquared = FMath::Square( i_MaxDistance );
+  auto SearchCell = [ & ]( int32 i_X, int32 i_Y, int32 i_Z )
+  {
+    const int32 Index = CellIndex( i_X, i_Y, i_Z );
+    for( int32 MarkerIndex = m_CellStarts[ Index ]; MarkerIndex < m_CellStarts[ Index + 1 ]; ++MarkerIndex )
+    {
+      const float DistanceSquared = FVector3f::DistSquared( i_rLocation, m_Markers[ MarkerIndex ].Position );
+      if( DistanceSquared <= BestDistanceSquared )
+      {
+        BestDistanceSquared = DistanceSquared;
+        BestMarker = MarkerIndex;
+      }
+    }
+  };
+
+  // Search shells of cells of growing radius around the cell nearest the location. A marker in shell R is at
+  // least R - 1 cells from the nearest point of the grid to the location, and no nearer to the location itself,
+  // so the search stops once that is further than the best marker so far.
+  const FIntVector Center = CellOf( i_rLocation );
+  const int32 MaxRadius = FMath::Max3( FMath::Max( Center.X, m_Dimensions.X - 1 - Center.X ),
+                                       FMath::Max( Center.Y, m_Dimensions.Y - 1 - Center.Y ),
+                                       FMath::Max( Center.Z, m_Dimensions.Z - 1 - Center.Z ) );
+  for( int32 Radius = 0; Radius <= MaxRadius; ++Radius )
+  {
+    if( Radius > 1 && FMath::Square( ( Radius - 1 ) * m_CellSize ) > BestDistanceSquared )
+    {
+      break;
+    }
+    const int32 MinX = FMath::Max( Center.X - Radius, 0 );
+    const int32 MaxX = FMath::Min( Center.X + Radius, m_Dimensions.X - 1 );
+    for( int32 Z = FMath::Max( Center.Z - Radius, 0 ); Z <= FMath::Min( Center.Z + Radius, m_Dimensions.Z - 1 ); ++Z )
+    {
+      for( int32 Y = FMath::Max( Center.Y - Radius, 0 ); Y <= FMath::Min( Center.Y + Radius, m_Dimensions.Y - 1 ); ++Y )
+      {
+        if( FMath::Abs( Z - Center.Z ) == Radius || FMath::Abs( Y - Center.Y ) == Radius )
+        {
+          for( int32 X = MinX; X <= MaxX; ++X )
+          {
+            SearchCell( X, Y, Z );
+          }
+        }
+        else
+        {
+          // Inside the shell's faces along Y and Z, only its two ends along X belong to it
+          if( Center.X - Radius >= 0 )
+          {
+            SearchCell( Center.X - Radius, Y, Z );
+          }
+          if( Center.X + Radius < m_Dimensions.X )
+          {
+            SearchCell( Center.X + Radius, Y, Z );
+          }
+        }
+      }
+    }
+  }
+  return BestMarker;
+}
+
+void FViconMarkerIndex::FindInRadius( const FVector3f& i_rLocation, float i_Radius, TArray< int32 >& io_rMarkers ) const
+{
+  FIntVector MinCell;
+  FIntVector MaxCell;
+  if( i_Radius < 0.0f || !CellRange( i_rLocation - FVector3f( i_Radius ), i_rLocation + FVector3f( i_Radius ), MinCell, MaxCell ) )
+  {
+    return;
+  }
+  const float RadiusSquared = FMath::Square( i_Radius );
+  for( int32 Z = MinCell.Z; Z <= MaxCell.Z; ++Z )
+  {
+    for( int32 Y = MinCell.Y; Y <= MaxCell.Y; ++Y )
+    {
+      // The cells of a row along X are contiguous, and so are their markers
+      const int32 End = m_CellStarts[ CellIndex( MaxCell.X, Y, Z ) + 1 ];
+      for( int32 MarkerIndex = m_CellStarts[ CellIndex( MinCell.X, Y, Z ) ]; MarkerIndex < End; ++MarkerIndex )
+      {
+        if( FVector3f::DistSquared( i_rLocation, m_Markers[ MarkerIndex ].Position ) <= RadiusSquared )
+        {
+          io_rMarkers.Add( MarkerIndex );
+        }
+      }
+    }
+  }
+}
+
+void FViconMarkerIndex::FindInBox( const FBox3f& i_rBox, TArray< int32 >& io_rMarkers ) const
+{
+  FIntVector MinCell;
+  FIntVector MaxCell;
+  if( !i_rBox.IsValid || !CellRange( i_rBox.Min, i_rBox.Max, MinCell, MaxCell ) )
+  {
+    return;
+  }
+  for( int32 Z = MinCell.Z; Z <= MaxCell.Z; ++Z )
+  {
+    for( int32 Y = MinCell.Y; Y <= MaxCell.Y; ++Y )
+    {
+      const int32 End = m_CellStarts[ CellIndex( MaxCell.X, Y, Z ) + 1 ];
+      for( int32 MarkerIndex = m_CellStarts[ CellIndex( MinCell.X, Y, Z ) ]; MarkerIndex < End; ++MarkerIndex )
+      {
+        if( i_rBox.IsInsideOrOn( m_Markers[ MarkerIndex ].Position ) )
+        {
+          io_rMarkers.Add( MarkerIndex );
+        }
+      }
+    }
+  }
+}
+
+void FViconMarkerIndexRegistry::Publish( const void* i_pPublisher, FViconMarkerIndexPtr i_Index )
+{
+  FViconMarkerIndexPtr Replaced;
+  {
+    FScopeLock Lock( &RegistryLock() );
+    TMap< const void*, FViconMarkerIndexPtr >& rIndices = PublishedIndices();
+    if( i_Index.IsValid() )
+    {
+      FViconMarkerIndexPtr& rPublished = rIndices.FindOrAdd( i_pPublisher );
+      Replaced = MoveTemp( rPublished );
+      rPublished = MoveTemp( i_Index );
+    }
+    else
+    {
+      rIndices.RemoveAndCopyValue( i_pPublisher, Replaced );
+    }
+  }
+  // The replaced index is released outside the lock, in case this was its last reference
+}
+
+void FViconMarkerIndexRegistry::GetPublished( TArray< FViconMarkerIndexPtr >& o_rIndices )
+{
+  FScopeLock Lock( &RegistryLock() );
+  PublishedIndices().GenerateValueArray( o_rIndices );
+}
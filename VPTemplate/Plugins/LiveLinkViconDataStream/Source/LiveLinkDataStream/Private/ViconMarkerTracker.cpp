@@ -0,0 +1,127 @@
+// Copyright (c) 2021 Vicon Motion Systems Ltd. All Rights Reserved.
+
+#include "ViconMarkerTracker.h"
+
+namespace
+{
+  // Frames a track coasts without a marker before it is dropped, about 40 ms at 240 Hz
+  const int32 s_MaxMissedFrames = 10;
+
+  FORCEINLINE FIntVector CellOf( const FVector3f& i_rPoint, float i_InvCellSize )
+  {
+    return FIntVector( FMath::FloorToInt32( i_rPoint.X * i_InvCellSize ),
+                       FMath::FloorToInt32( i_rPoint.Y * i_InvCellSize ),
+                       FMath::FloorToInt32( i_rPoint.Z * i_InvCellSize ) );
+  }
+}
+
+void FViconMarkerTracker::Track( TArrayView< const FVector3f > i_Points, float i_GateDistance, TArrayView< int32 > o_Ids )
+{
+  check( o_Ids.Num() >= i_Points.Num() );
+  const int32 NumPoints = i_Points.Num();
+  const int32 NumTracks = m_Tracks.Num();
+  const float GateDistance = FMath::Max( i_GateDistance, UE_KINDA_SMALL_NUMBER );
+  const float GateDistanceSquared = GateDistance * GateDistance;
+  const float InvCellSize = 1.0f / GateDistance;
+
+  // Bucket the predicted position of every track
+  m_CellHeads.Reset();
+  m_NextInCell.SetNumUninitialized( NumTracks, false );
+  m_Predicted.SetNumUninitialized( NumTracks, false );
+  for( int32 TrackIndex = 0; TrackIndex < NumTracks; ++TrackIndex )
+  {
+    const FTrack& rTrack = m_Tracks[ TrackIndex ];
+    m_Predicted[ TrackIndex ] = rTrack.Position + rTrack.Velocity * static_cast< float >( rTrack.MissedFrames + 1 );
+    int32& rHead = m_CellHeads.FindOrAdd( CellOf( m_Predicted[ TrackIndex ], InvCellSize ), INDEX_NONE );
+    m_NextInCell[ TrackIndex ] = rHead;
+    rHead = TrackIndex;
+  }
+
+  // Nearest track of each point. The gate is one cell wide, so any track within it is in a neighbouring cell.
+  m_PointTrack.SetNumUninitialized( NumPoints, false );
+  m_PointDistanceSquared.SetNumUninitialized( NumPoints, false );
+  m_TrackPoint.Init( INDEX_NONE, NumTracks );
+  for( int32 PointIndex = 0; PointIndex < NumPoints; ++PointIndex )
+  {
+    const FVector3f& rPoint = i_Points[ PointIndex ];
+    const FIntVector Cell = CellOf( rPoint, InvCellSize );
+    int32 BestTrack = INDEX_NONE;
+    float BestDistanceSquared = GateDistanceSquared;
+    for( int32 Z = -1; Z <= 1; ++Z )
+    {
+      for( int32 Y = -1; Y <= 1; ++Y )
+      {
+        for( int32 X = -1; X <= 1; ++X )
+        {
+          const int32* pHead = m_CellHeads.Find( Cell + FIntVector( X, Y, Z ) );
+          for( int32 TrackIndex = pHead ? *pHead : INDEX_NONE; TrackIndex != INDEX_NONE; TrackIndex = m_NextInCell[ TrackIndex ] )
+          {
+            const float DistanceSquared = FVector3f::DistSquared( rPoint, m_Predicted[ TrackIndex ] );
+            if( DistanceSquared <= BestDistanceSquared )
+            {
+              BestDistanceSquared = DistanceSquared;
+              BestTrack = TrackIndex;
+            }
+          }
+        }
+      }
+    }
+    m_PointTrack[ PointIndex ] = BestTrack;
+    m_PointDistanceSquared[ PointIndex ] = BestDistanceSquared;
+
+    // The nearest of the points claiming a track continues it
+    if( BestTrack != INDEX_NONE )
+    {
+      int32& rTrackPoint = m_TrackPoint[ BestTrack ];
+      if( rTrackPoint == INDEX_NONE || BestDistanceSquared < m_PointDistanceSquared[ rTrackPoint ] )
+      {
+        rTrackPoint = PointIndex;
+      }
+    }
+  }
+
+  m_NextTracks.Reset( NumPoints + NumTracks );
+  for( int32 PointIndex = 0; PointIndex < NumPoints; ++PointIndex )
+  {
+    const FVector3f& rPoint = i_Points[ PointIndex ];
+    const int32 TrackIndex = m_PointTrack[ PointIndex ];
+    FTrack& rNextTrack = m_NextTracks.AddDefaulted_GetRef();
+    rNextTrack.Position = rPoint;
+    if( TrackIndex != INDEX_NONE && m_TrackPoint[ TrackIndex ] == PointIndex )
+    {
+      const FTrack& rTrack = m_Tracks[ TrackIndex ];
+      rNextTrack.Velocity = ( rPoint - rTrack.Position ) / static_cast< float >( rTrack.MissedFrames + 1 );
+      rNextTrack.Id = rTrack.Id;
+    }
+    else
+    {
+      rNextTrack.Id = m_NextId++;
+    }
+    o_Ids[ PointIndex ] = rNextTrack.Id;
+  }
+
+  // Tracks with no marker this frame coast for a while, predicted on from their last position
+  for( int32 TrackIndex = 0; TrackIndex < NumTracks; ++TrackIndex )
+  {
+    const FTrack& rTrack = m_Tracks[ TrackIndex ];
+    if( m_TrackPoint[ TrackIndex ] == INDEX_NONE && rTrack.MissedFrames < s_MaxMissedFrames )
+    {
+      ++m_NextTracks.Add_GetRef( rTrack ).MissedFrames;
+    }
+  }
+
+  Swap( m_Tracks, m_NextTracks );
+}
+
+void FViconMarkerTracker::Reset()
+{
+  m_Tracks.Empty();
+  m_NextTracks.Empty();
+  m_CellHeads.Empty();
+  m_NextInCell.Empty();
+  m_Predicted.Empty();
+  m_PointTrack.Empty();
+  m_PointDistanceSquared.Empty();
+  m_TrackPoint.Empty();
+  m_NextId = 0;
+}
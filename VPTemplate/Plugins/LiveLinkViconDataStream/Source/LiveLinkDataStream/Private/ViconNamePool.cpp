@@ -0,0 +1,86 @@
+// Copyright (c) 2021 Vicon Motion Systems Ltd. All Rights Reserved.
+
+#include "ViconNamePool.h"
+
+#include "ViconStream.h"
+
+#include "Hash/CityHash.h"
+
+FViconNamePool& FViconNamePool::Get()
+{
+  static FViconNamePool s_Pool;
+  return s_Pool;
+}
+
+FViconNamePool::~FViconNamePool()
+{
+  for( FEntry*& rChunk : m_Chunks )
+  {
+    delete[] rChunk;
+    rChunk = nullptr;
+  }
+}
+
+FViconNameId FViconNamePool::Intern( const char* i_pUtf8, int32 i_Length )
+{
+  const uint64 Hash = CityHash64( i_pUtf8, static_cast< uint32 >( i_Length ) );
+  {
+    FReadScopeLock ReadLock( m_Lock );
+    const int32 Id = Find( i_pUtf8, i_Length, Hash );
+    if( Id != INDEX_NONE )
+    {
+      return static_cast< FViconNameId >( Id );
+    }
+  }
+
+  FWriteScopeLock WriteLock( m_Lock );
+  // Another thread may have added it since the read lock was released
+  const int32 ExistingId = Find( i_pUtf8, i_Length, Hash );
+  if( ExistingId != INDEX_NONE )
+  {
+    return static_cast< FViconNameId >( ExistingId );
+  }
+
+  const int32 Id = m_NumEntries.load( std::memory_order_relaxed );
+  const int32 ChunkIndex = Id / ChunkSize;
+  if( ChunkIndex >= MaxChunks )
+  {
+    UE_LOG( LogViconStream, Fatal, TEXT( "More than %d distinct names from the Vicon DataStream" ), MaxChunks * ChunkSize );
+  }
+  if( !m_Chunks[ ChunkIndex ] )
+  {
+    m_Chunks[ ChunkIndex ] = new FEntry[ ChunkSize ];
+  }
+
+  FEntry& rEntry = m_Chunks[ ChunkIndex ][ Id % ChunkSize ];
+  rEntry.Utf8.assign( i_pUtf8, i_Length );
+  rEntry.Name = FString( UTF8_TO_TCHAR( rEntry.Utf8.c_str() ) );
+  rEntry.Hash = Hash;
+  int32& rBucket = m_Buckets.FindOrAdd( Hash, INDEX_NONE );
+  rEntry.NextInBucket = rBucket;
+  rBucket = Id;
+
+  m_NumEntries.store( Id + 1, std::memory_order_release );
+  return static_cast< FViconNameId >( Id );
+}
+
+FViconNameId FViconNamePool::Intern( const FString& i_rName )
+{
+  const FTCHARToUTF8 Utf8( *i_rName );
+  return Intern( Utf8.Get(), Utf8.Length() );
+}
+
+int32 FViconNamePool::Find( const char* i_pUtf8, int32 i_Length, uint64 i_Hash ) const
+{
+  const int32* pBucket = m_Buckets.Find( i_Hash );
+  for( int32 Id = pBucket ? *pBucket : INDEX_NONE; Id != INDEX_NONE; )
+  {
+    const FEntry& rEntry = GetEntry( static_cast< FViconNameId >( Id ) );
+    if( rEntry.Utf8.size() == static_cast< size_t >( i_Length ) && FMemory::Memcmp( rEntry.Utf8.data(), i_pUtf8, i_Length ) == 0 )
+    {
+      return Id;
+    }
+    Id = rEntry.NextInBucket;
+  }
+  return INDEX_NONE;
+}
@@ -0,0 +1,259 @@
+// Copyright (c) 2021 Vicon Motion Systems Ltd. All Rights Reserved.
+
+#include "ViconPoseKernel.h"
+
+#include "ViconStream.h"
+
+const FQuat FViconPoseKernel::YUpRotation = FQuat( FVector::XAxisVector, HALF_PI );
+
+namespace
+{
+  FORCEINLINE void StoreTransform( const VectorRegister4Double& i_rRotation, const VectorRegister4Double& i_rTranslation,
+                                   const VectorRegister4Double& i_rScale, FTransform& o_rPose )
+  {
+#if ENABLE_VECTORIZED_TRANSFORM
+    o_rPose = FTransform( i_rRotation, i_rTranslation, i_rScale );
+#else
+    FQuat Quat;
+    FVector Vector;
+    VectorStore( i_rRotation, &Quat.X );
+    o_rPose.SetRotation( Quat );
+    VectorStoreFloat3( i_rTranslation, &Vector.X );
+    o_rPose.SetTranslation( Vector );
+    VectorStoreFloat3( i_rScale, &Vector.X );
+    o_rPose.SetScale3D( Vector );
+#endif
+  }
+
+  // Fall back to the cached pose of an occluded segment. Returns false if there is none.
+  FORCEINLINE bool UseCachedPose( FViconSubjectPoseCache* io_pCache, int32 i_BoneIndex, FTransform& o_rPose )
+  {
+    if( io_pCache && io_pCache->bValid[ i_BoneIndex ] )
+    {
+      o_rPose = io_pCache->Poses[ i_BoneIndex ];
+      UE_LOG( LogViconStream, Log, TEXT( "Segment is occluded, using cached data" ) );
+      return true;
+    }
+    UE_LOG( LogViconStream, Log, TEXT( "Segment is occluded and there's no cached data either" ) );
+    return false;
+  }
+
+  FORCEINLINE void CachePose( FViconSubjectPoseCache* io_pCache, int32 i_BoneIndex, const FTransform& i_rPose )
+  {
+    if( io_pCache )
+    {
+      io_pCache->Poses[ i_BoneIndex ] = i_rPose;
+      io_pCache->bValid[ i_BoneIndex ] = true;
+    }
+  }
+
+  // Convert one segment. bHierarchyScale is false for roots, whose hierarchy scale is always one.
+  template< bool bUseScaling, bool bHierarchyScale >
+  FORCEINLINE bool ConvertSegment( const FViconRawSegment& i_rSegment, const FVector* i_pHierarchyScale, FViconSubjectPoseCache* io_pCache,
+                                   int32 i_BoneIndex, FTransform& o_rPose )
+  {
+    if( !i_rSegment.bTranslationValid )
+    {
+      return UseCachedPose( io_pCache, i_BoneIndex, o_rPose );
+    }
+    if( !i_rSegment.bRotationValid || i_rSegment.Rotation[ 3 ] == 0 )
+    {
+      return false;
+    }
+
+    // Mirror the xz plane and convert mm to cm in one multiply
+    VectorRegister4Double Translation = VectorMultiply( VectorLoadFloat3_W0( i_rSegment.Translation ), MakeVectorRegisterDouble( 0.1, -0.1, 0.1, 0.0 ) );
+    if constexpr( bUseScaling && bHierarchyScale )
+    {
+      // Components with a zero scale are left as they are; this includes w, which is zero in both
+      const VectorRegister4Double HierarchyScale = VectorLoadFloat3_W0( &i_pHierarchyScale->X );
+      Translation = VectorSelect( VectorCompareEQ( HierarchyScale, VectorZeroDouble() ), Translation, VectorDivide( Translation, HierarchyScale ) );
+    }
+    const VectorRegister4Double Rotation = VectorMultiply( VectorLoad( i_rSegment.Rotation ), MakeVectorRegisterDouble( -1.0, 1.0, -1.0, 1.0 ) );
+    VectorRegister4Double Scale = MakeVectorRegisterDouble( 1.0, 1.0, 1.0, 0.0 );
+    if constexpr( bUseScaling )
+    {
+      Scale = i_rSegment.bHasStaticScale ? VectorLoadFloat3_W0( i_rSegment.StaticScale ) : Scale;
+    }
+
+    StoreTransform( Rotation, Translation, Scale, o_rPose );
+    CachePose( io_pCache, i_BoneIndex, o_rPose );
+    return true;
+  }
+
+  template< bool bUseScaling, bool bYUp >
+  int32 ConvertSkeleton( TArrayView< const FViconRawSegment > i_Segments, const FVector* i_pHierarchyScales,
+                         FViconSubjectPoseCache* io_pCache, TArrayView< FTransform > o_Poses )
+  {
+    check( o_Poses.Num() >= i_Segments.Num() );
+    const int32 NumSegments = i_Segments.Num();
+    for( int32 BoneIndex = 0; BoneIndex < NumSegments; ++BoneIndex )
+    {
+      if( !ConvertSegment< bUseScaling, true >( i_Segments[ BoneIndex ], bUseScaling ? i_pHierarchyScales + BoneIndex : nullptr, io_pCache, BoneIndex, o_Poses[ BoneIndex ] ) )
+      {
+        return BoneIndex;
+      }
+    }
+    if constexpr( bYUp )
+    {
+      if( NumSegments > 0 )
+      {
+        o_Poses[ 0 ] = o_Poses[ 0 ] * FViconPoseKernel::YUpRotation;
+      }
+    }
+    return INDEX_NONE;
+  }
+
+  template< bool bUseScaling, bool bYUp >
+  int32 ConvertRigidBody( TArrayView< const FViconRawSegment > i_Segments, const FVector* i_pHierarchyScales,
+                          FViconSubjectPoseCache* io_pCache, TArrayView< FTransform > o_Poses )
+  {
+    if( i_Segments.Num() < 1 || !ConvertSegment< bUseScaling, false >( i_Segments[ 0 ], nullptr, io_pCache, 0, o_Poses[ 0 ] ) )
+    {
+      return 0;
+    }
+    if constexpr( bYUp )
+    {
+      o_Poses[ 0 ] = o_Poses[ 0 ] * FViconPoseKernel::YUpRotation;
+    }
+    return INDEX_NONE;
+  }
+
+  // Unreal matrices transform row vectors, so a marker becomes x * row 0 + y * row 1 + z * row 2
+  FORCEINLINE VectorRegister4Float TransformMarker( const double* i_pTranslation, const VectorRegister4Double& i_rRow0,
+                                                    const VectorRegister4Double& i_rRow1, const VectorRegister4Double& i_rRow2 )
+  {
+    VectorRegister4Double Marker = VectorMultiply( VectorLoadDouble1( i_pTranslation ), i_rRow0 );
+    Marker = VectorMultiplyAdd( VectorLoadDouble1( i_pTranslation + 1 ), i_rRow1, Marker );
+    Marker = VectorMultiplyAdd( VectorLoadDouble1( i_pTranslation + 2 ), i_rRow2, Marker );
+    return MakeVectorRegisterFloatFromDouble( Marker );
+  }
+
+  template< bool bYUp >
+  void ConvertMarkers( const double* i_pTranslations, int32 i_NumMarkers, float* o_pMarkers )
+  {
+    static const FMatrix MarkerMatrix = FViconPoseKernel::MakeMarkerMatrix( bYUp );
+    FViconPoseKernel::ConvertMarkerBatch( i_pTranslations, i_NumMarkers, MarkerMatrix, o_pMarkers );
+  }
+}
+
+FViconPoseKernel::FSegmentConverters FViconPoseKernel::SelectSegmentConverters( bool i_bUseScaling )
+{
+  FSegmentConverters Converters;
+  if( i_bUseScaling )
+  {
+    Converters.RigidBody[ 0 ] = &ConvertRigidBody< true, false >;
+    Converters.RigidBody[ 1 ] = &ConvertRigidBody< true, true >;
+    Converters.Skeleton[ 0 ] = &ConvertSkeleton< true, false >;
+    Converters.Skeleton[ 1 ] = &ConvertSkeleton< true, true >;
+  }
+  else
+  {
+    Converters.RigidBody[ 0 ] = &ConvertRigidBody< false, false >;
+    Converters.RigidBody[ 1 ] = &ConvertRigidBody< false, true >;
+    Converters.Skeleton[ 0 ] = &ConvertSkeleton< false, false >;
+    Converters.Skeleton[ 1 ] = &ConvertSkeleton< false, true >;
+  }
+  return Converters;
+}
+
+FViconPoseKernel::FMarkerConverter FViconPoseKernel::SelectMarkerConverter( bool i_bYUp )
+{
+  return i_bYUp ? &ConvertMarkers< true > : &ConvertMarkers< false >;
+}
+
+FMatrix FViconPoseKernel::MakeMarkerMatrix( bool i_bYUp )
+{
+  // Mirror the xz plane and convert mm to cm. With Y up axis mapping this is followed by YUpRotation,
+  // a quarter turn about x, which maps (x, y, z) to (x, -z, y).
+  FMatrix MarkerMatrix = FScaleMatrix( FVector( 0.1, -0.1, 0.1 ) );
+  if( i_bYUp )
+  {
+    MarkerMatrix = MarkerMatrix * FQuatRotationMatrix( YUpRotation );
+  }
+  return MarkerMatrix;
+}
+
+void FViconPoseKernel::ConvertMarkerBatch( const double* i_pTranslations, int32 i_NumMarkers, const FMatrix& i_rMatrix, float* o_pMarkers )
+{
+  if( i_NumMarkers <= 0 )
+  {
+    return;
+  }
+
+  const VectorRegister4Double Row0 = VectorLoadFloat3_W0( i_rMatrix.M[ 0 ] );
+  const VectorRegister4Double Row1 = VectorLoadFloat3_W0( i_rMatrix.M[ 1 ] );
+  const VectorRegister4Double Row2 = VectorLoadFloat3_W0( i_rMatrix.M[ 2 ] );
+
+  // Every marker but the last is stored as four floats, the fourth of which is overwritten by the next marker,
+  // so the loop needs no partial stores
+  const int32 LastMarker = i_NumMarkers - 1;
+  for( int32 MarkerIndex = 0; MarkerIndex < LastMarker; ++MarkerIndex )
+  {
+    VectorStore( TransformMarker( i_pTranslations + MarkerIndex * 3, Row0, Row1, Row2 ), o_pMarkers + MarkerIndex * 3 );
+  }
+  VectorStoreFloat3( TransformMarker( i_pTranslations + LastMarker * 3, Row0, Row1, Row2 ), o_pMarkers + LastMarker * 3 );
+}
+
+bool FViconPoseKernel::SortBonesParentFirst( TArrayView< const int32 > i_BoneParents, TArray< int32 >& o_rOrder )
+{
+  const int32 NumBones = i_BoneParents.Num();
+  o_rOrder.Reset( NumBones );
+
+  // Breadth first from the roots, with the children of each bone in a contiguous run of Children
+  TArray< int32 > FirstChild;
+  TArray< int32 > Children;
+  FirstChild.SetNumZeroed( NumBones + 1 );
+  Children.SetNumUninitialized( NumBones );
+  for( int32 BoneIndex = 0; BoneIndex < NumBones; ++BoneIndex )
+  {
+    const int32 Parent = i_BoneParents[ BoneIndex ];
+    if( Parent == INDEX_NONE )
+    {
+      o_rOrder.Add( BoneIndex );
+    }
+    else if( Parent >= 0 && Parent < NumBones )
+    {
+      ++FirstChild[ Parent + 1 ];
+    }
+    else
+    {
+      return false;
+    }
+  }
+  for( int32 BoneIndex = 0; BoneIndex < NumBones; ++BoneIndex )
+  {
+    FirstChild[ BoneIndex + 1 ] += FirstChild[ BoneIndex ];
+  }
+  TArray< int32 > NextChild( FirstChild );
+  for( int32 BoneIndex = 0; BoneIndex < NumBones; ++BoneIndex )
+  {
+    const int32 Parent = i_BoneParents[ BoneIndex ];
+    if( Parent != INDEX_NONE )
+    {
+      Children[ NextChild[ Parent ]++ ] = BoneIndex;
+    }
+  }
+
+  for( int32 Visited = 0; Visited < o_rOrder.Num(); ++Visited )
+  {
+    const int32 BoneIndex = o_rOrder[ Visited ];
+    for( int32 ChildIndex = FirstChild[ BoneIndex ]; ChildIndex < FirstChild[ BoneIndex + 1 ]; ++ChildIndex )
+    {
+      o_rOrder.Add( Children[ ChildIndex ] );
+    }
+  }
+  // Bones in a cycle are never reached from a root
+  return o_rOrder.Num() == NumBones;
+}
+
+void FViconPoseKernel::LocalToComponentSpace( TArrayView< const FTransform > i_LocalPoses, TArrayView< const int32 > i_BoneParents,
+                                              TArrayView< const int32 > i_SolveOrder, TArrayView< FTransform > o_ComponentPoses )
+{
+  check( i_LocalPoses.Num() == i_BoneParents.Num() && o_ComponentPoses.Num() >= i_LocalPoses.Num() );
+  for( const int32 BoneIndex : i_SolveOrder )
+  {
+    const int32 Parent = i_BoneParents[ BoneIndex ];
+    o_ComponentPoses[ BoneIndex ] = ( Parent == INDEX_NONE ) ? i_LocalPoses[ BoneIndex ] : i_LocalPoses[ BoneIndex ] * o_ComponentPoses[ Parent ];
+  }
+}
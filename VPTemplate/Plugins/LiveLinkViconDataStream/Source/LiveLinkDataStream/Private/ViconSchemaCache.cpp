@@ -0,0 +1,190 @@
+// Copyright (c) 2021 Vicon Motion Systems Ltd. All Rights Reserved.
+
+#include "ViconSchemaCache.h"
+
+#include "ViconStream.h"
+
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+namespace
+{
+  const uint32 s_SchemaCacheMagic = 0x48435356; // "VSCH"
+  // 2: static scale of each bone
+  const uint32 s_SchemaCacheVersion = 2;
+  // Limits on what a cache file may hold, so a corrupt file is rejected rather than allocating without bound
+  const int32 s_MaxCachedSubjects = 4096;
+  const int32 s_MaxCachedNames = 65536;
+  const int32 s_MaxNameLength = 1024;
+
+  void WriteNames( FArchive& io_rArchive, const TArray< FViconNameId >& i_rNames )
+  {
+    const FViconNamePool& rPool = FViconNamePool::Get();
+    int32 NumNames = i_rNames.Num();
+    io_rArchive << NumNames;
+    for( const FViconNameId NameId : i_rNames )
+    {
+      const std::string& rName = rPool.GetUtf8( NameId );
+      int32 Length = static_cast< int32 >( rName.size() );
+      io_rArchive << Length;
+      io_rArchive.Serialize( const_cast< char* >( rName.data() ), Length );
+    }
+  }
+
+  bool ReadNames( FArchive& io_rArchive, TArray< FViconNameId >& o_rNames )
+  {
+    int32 NumNames = 0;
+    io_rArchive << NumNames;
+    if( io_rArchive.IsError() || NumNames < 0 || NumNames > s_MaxCachedNames )
+    {
+      return false;
+    }
+
+    FViconNamePool& rPool = FViconNamePool::Get();
+    o_rNames.Reset( NumNames );
+    std::string Name;
+    for( int32 NameIndex = 0; NameIndex < NumNames; ++NameIndex )
+    {
+      int32 Length = 0;
+      io_rArchive << Length;
+      if( io_rArchive.IsError() || Length < 0 || Length > s_MaxNameLength )
+      {
+        return false;
+      }
+      Name.resize( Length );
+      io_rArchive.Serialize( Name.data(), Length );
+      if( io_rArchive.IsError() )
+      {
+        return false;
+      }
+      o_rNames.Add( rPool.Intern( Name ) );
+    }
+    return true;
+  }
+
+  bool ReadSchema( FArchive& io_rArchive, FViconSkeletonTemplateRegistry& io_rTemplates, FViconSubjectSchema& o_rSchema )
+  {
+    TArray< FViconNameId > Bones;
+    TArray< FViconNameId > Markers;
+    if( !ReadNames( io_rArchive, Bones ) || !ReadNames( io_rArchive, Markers ) )
+    {
+      return false;
+    }
+
+    const int32 NumBones = Bones.Num();
+    TArray< int32 > BoneParents;
+    BoneParents.SetNumUninitialized( NumBones );
+    o_rSchema.HierarchyScales.SetNumUninitialized( NumBones );
+    o_rSchema.StaticScales.SetNumUninitialized( NumBones );
+    for( int32 BoneIndex = 0; BoneIndex < NumBones; ++BoneIndex )
+    {
+      FVector& rScale = o_rSchema.HierarchyScales[ BoneIndex ];
+      FVector& rStaticScale = o_rSchema.StaticScales[ BoneIndex ];
+      int32& rParent = BoneParents[ BoneIndex ];
+      io_rArchive << rParent;
+      io_rArchive << rScale.X << rScale.Y << rScale.Z;
+      io_rArchive << rStaticScale.X << rStaticScale.Y << rStaticScale.Z;
+      if( io_rArchive.IsError() || rParent < INDEX_NONE || rParent >= NumBones )
+      {
+        return false;
+      }
+    }
+
+    o_rSchema.Template = io_rTemplates.FindOrAdd( MoveTemp( Bones ), MoveTemp( Markers ), MoveTemp( BoneParents ) );
+    return true;
+  }
+}
+
+FString FViconSchemaCache::GetFilePath( const FString& i_rServerAddress, const FString& i_rSubjectPrefix )
+{
+  FString FileName = i_rServerAddress;
+  if( !i_rSubjectPrefix.IsEmpty() )
+  {
+    FileName += TEXT( "_" ) + i_rSubjectPrefix;
+  }
+  FileName = FPaths::MakeValidFileName( FileName, TEXT( '_' ) ) + TEXT( ".vsc" );
+  return FPaths::Combine( FPaths::ProjectSavedDir(), TEXT( "ViconDataStream" ), TEXT( "SchemaCache" ), FileName );
+}
+
+bool FViconSchemaCache::Load( const FString& i_rFilePath, FViconSkeletonTemplateRegistry& io_rTemplates, TArray< FViconCachedSchema >& o_rSchemas )
+{
+  o_rSchemas.Reset();
+
+  TArray< uint8 > Bytes;
+  if( !IFileManager::Get().FileExists( *i_rFilePath ) || !FFileHelper::LoadFileToArray( Bytes, *i_rFilePath ) )
+  {
+    return false;
+  }
+
+  FMemoryReader Reader( Bytes );
+  uint32 Magic = 0;
+  uint32 Version = 0;
+  int32 NumSubjects = 0;
+  Reader << Magic << Version << NumSubjects;
+  if( Reader.IsError() || Magic != s_SchemaCacheMagic || Version != s_SchemaCacheVersion ||
+      NumSubjects < 0 || NumSubjects > s_MaxCachedSubjects )
+  {
+    UE_LOG( LogViconStream, Warning, TEXT( "Ignoring schema cache %s, it is not a schema cache this version can read" ), *i_rFilePath );
+    return false;
+  }
+
+  o_rSchemas.Reserve( NumSubjects );
+  for( int32 SubjectIndex = 0; SubjectIndex < NumSubjects; ++SubjectIndex )
+  {
+    FString SubjectName;
+    Reader << SubjectName;
+
+    TSharedRef< FViconSubjectSchema, ESPMode::ThreadSafe > Schema = MakeShared< FViconSubjectSchema, ESPMode::ThreadSafe >();
+    if( Reader.IsError() || !ReadSchema( Reader, io_rTemplates, *Schema ) )
+    {
+      UE_LOG( LogViconStream, Warning, TEXT( "Ignoring schema cache %s, it is truncated or corrupt" ), *i_rFilePath );
+      o_rSchemas.Reset();
+      return false;
+    }
+    o_rSchemas.Add( { FViconNamePool::Get().Intern( SubjectName ), Schema } );
+  }
+  return true;
+}
+
+void FViconSchemaCache::Encode( TArrayView< const FViconCachedSchema > i_Schemas, TArray< uint8 >& o_rBytes )
+{
+  o_rBytes.Reset();
+  FMemoryWriter Writer( o_rBytes );
+
+  uint32 Magic = s_SchemaCacheMagic;
+  uint32 Version = s_SchemaCacheVersion;
+  int32 NumSubjects = i_Schemas.Num();
+  Writer << Magic << Version << NumSubjects;
+
+  for( const FViconCachedSchema& rCachedSchema : i_Schemas )
+  {
+    const FViconSubjectSchema& rSchema = *rCachedSchema.Schema;
+    const FViconSkeletonTemplate& rTemplate = *rSchema.Template;
+    FString SubjectName = FViconNamePool::Get().GetString( rCachedSchema.SubjectName );
+    Writer << SubjectName;
+    WriteNames( Writer, rTemplate.Bones );
+    WriteNames( Writer, rTemplate.Markers );
+    for( int32 BoneIndex = 0; BoneIndex < rTemplate.Bones.Num(); ++BoneIndex )
+    {
+      int32 Parent = rTemplate.BoneParents.IsValidIndex( BoneIndex ) ? rTemplate.BoneParents[ BoneIndex ] : INDEX_NONE;
+      FVector Scale = rSchema.HierarchyScales.IsValidIndex( BoneIndex ) ? rSchema.HierarchyScales[ BoneIndex ] : FVector::OneVector;
+      FVector StaticScale = rSchema.StaticScales.IsValidIndex( BoneIndex ) ? rSchema.StaticScales[ BoneIndex ] : FVector::OneVector;
+      Writer << Parent;
+      Writer << Scale.X << Scale.Y << Scale.Z;
+      Writer << StaticScale.X << StaticScale.Y << StaticScale.Z;
+    }
+  }
+}
+
+bool FViconSchemaCache::Save( const FString& i_rFilePath, const TArray< uint8 >& i_rBytes )
+{
+  if( !FFileHelper::SaveArrayToFile( i_rBytes, *i_rFilePath ) )
+  {
+    UE_LOG( LogViconStream, Warning, TEXT( "Failed to write schema cache %s" ), *i_rFilePath );
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,107 @@
+// Copyright (c) 2021 Vicon Motion Systems Ltd. All Rights Reserved.
+
+#include "ViconSkeletonTemplate.h"
+
+#include "ViconPoseKernel.h"
+#include "ViconStreamFrameReader.h"
+
+#include "Hash/CityHash.h"
+
+namespace
+{
+  // Ids are stable for the lifetime of the module, so the content can be hashed without looking up the names
+  template< typename T >
+  uint64 HashArray( const TArray< T >& i_rArray, uint64 i_Seed )
+  {
+    const int32 Num = i_rArray.Num();
+    const uint64 Hash = CityHash64WithSeed( reinterpret_cast< const char* >( &Num ), sizeof( Num ), i_Seed );
+    return CityHash64WithSeed( reinterpret_cast< const char* >( i_rArray.GetData() ), static_cast< uint32 >( Num * sizeof( T ) ), Hash );
+  }
+
+  uint64 HashTemplate( const TArray< FViconNameId >& i_rBones, const TArray< FViconNameId >& i_rMarkers, const TArray< int32 >& i_rBoneParents )
+  {
+    return HashArray( i_rBoneParents, HashArray( i_rMarkers, HashArray( i_rBones, 0 ) ) );
+  }
+}
+
+FViconSkeletonTemplatePtr FViconSkeletonTemplateRegistry::FindOrAdd( TArray< FViconNameId >&& i_rBones, TArray< FViconNameId >&& i_rMarkers, TArray< int32 >&& i_rBoneParents )
+{
+  const uint64 Hash = HashTemplate( i_rBones, i_rMarkers, i_rBoneParents );
+
+  // Compare the content as well, so that a hash collision can't hand a subject another skeleton
+  TArray< FWeakTemplatePtr >& rBucket = m_Templates.FindOrAdd( Hash );
+  for( int32 Index = rBucket.Num() - 1; Index >= 0; --Index )
+  {
+    FViconSkeletonTemplatePtr Template = rBucket[ Index ].Pin();
+    if( !Template.IsValid() )
+    {
+      rBucket.RemoveAtSwap( Index );
+    }
+    else if( Template->Bones == i_rBones && Template->BoneParents == i_rBoneParents && Template->Markers == i_rMarkers )
+    {
+      return Template;
+    }
+  }
+
+  TSharedRef< FViconSkeletonTemplate, ESPMode::ThreadSafe > Template = MakeShared< FViconSkeletonTemplate, ESPMode::ThreadSafe >();
+  Template->Hash = Hash;
+  Template->Bones = MoveTemp( i_rBones );
+  Template->Markers = MoveTemp( i_rMarkers );
+  Template->BoneParents = MoveTemp( i_rBoneParents );
+  if( !FViconPoseKernel::SortBonesParentFirst( Template->BoneParents, Template->SolveOrder ) )
+  {
+    Template->SolveOrder.Empty();
+  }
+
+  Template->BoneNames.Reserve( Template->Bones.Num() );
+  const FViconNamePool& rPool = FViconNamePool::Get();
+  for( const FViconNameId Bone : Template->Bones )
+  {
+    Template->BoneNames.Emplace( *rPool.GetString( Bone ) );
+  }
+  Template->PropertyNames = MarkerPropertiesFromNames( Template->Markers );
+
+  rBucket.Add( Template );
+  return Template;
+}
+
+void FViconSkeletonTemplateRegistry::Prune()
+{
+  for( auto It = m_Templates.CreateIterator(); It; ++It )
+  {
+    It.Value().RemoveAllSwap( []( const FWeakTemplatePtr& rTemplate ) { return !rTemplate.IsValid(); } );
+    if( It.Value().Num() == 0 )
+    {
+      It.RemoveCurrent();
+    }
+  }
+}
+
+int32 FViconSkeletonTemplateRegistry::Num() const
+{
+  int32 NumTemplates = 0;
+  for( const auto& rBucket : m_Templates )
+  {
+    for( const FWeakTemplatePtr& rTemplate : rBucket.Value )
+    {
+      NumTemplates += rTemplate.IsValid() ? 1 : 0;
+    }
+  }
+  return NumTemplates;
+}
+
+TArray< FName > FViconSkeletonTemplateRegistry::MarkerPropertiesFromNames( const TArray< FViconNameId >& i_rMarkerNames )
+{
+  const FViconNamePool& rPool = FViconNamePool::Get();
+  TArray< FName > MarkerProperties;
+  MarkerProperties.Reserve( 1 + i_rMarkerNames.Num() * 3 );
+  MarkerProperties.Emplace( FViconStreamFrameReader::MARKER_COUNT_PROPERTY.c_str() );
+  for( const FViconNameId MarkerId : i_rMarkerNames )
+  {
+    const std::string& MarkerName = rPool.GetUtf8( MarkerId );
+    MarkerProperties.Emplace( ( MarkerName + "_X" ).c_str() );
+    MarkerProperties.Emplace( ( MarkerName + "_Y" ).c_str() );
+    MarkerProperties.Emplace( ( MarkerName + "_Z" ).c_str() );
+  }
+  return MarkerProperties;
+}
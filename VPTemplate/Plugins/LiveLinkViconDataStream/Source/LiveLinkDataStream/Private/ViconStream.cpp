@@ -5,11 +5,15 @@
 #include "Roles/LiveLinkAnimationTypes.h"
 #include "Roles/LiveLinkTransformTypes.h"
 #include "ViconLensModel.h"
+#include "ViconPoseKernel.h"
 
+#include "Async/Async.h"
 #include "CommonFrameRates.h"
+#include "HAL/Event.h"
 #include "LiveLinkLensTypes.h"
 #include "Misc/Paths.h"
 
+#include <atomic>
 #include <iostream>
 #include <string>
 
@@ -24,7 +28,6 @@ namespace
 {
 
   static double s_RetimedFrameRate = 180.0;
-  static FQuat s_YUpRotation = FQuat( FVector::XAxisVector, HALF_PI );
 
   void LiveLinkTimeCodeFromViconTimeCode( const ViconDataStreamSDK::CPP::Output_GetTimecode& i_rTimeCode, FQualifiedFrameTime& o_rTimeCode )
   {
@@ -67,6 +70,7 @@ namespace
 
 ViconStream::ViconStream()
 : m_bUseScaling( true )
+, m_SegmentConverters( FViconPoseKernel::SelectSegmentConverters( true ) )
 , m_Offset( 0.0 )
 , m_bRetimed( false )
 {
@@ -183,6 +187,37 @@ unsigned int ViconStream::GetFrameNumber()
   return 0;
 }
 
+unsigned int ViconStream::GetHardwareFrameNumber()
+{
+  if( !m_bRetimed )
+  {
+    return m_Client.GetHardwareFrameNumber().HardwareFrameNumber;
+  }
+  return 0;
+}
+
+void ViconStream::CaptureFrameContext( FViconFrameContext& io_rContext )
+{
+  io_rContext.bYUp = IsViconServerYup();
+
+  io_rContext.FrameRateHz = 0.0;
+  if( !m_bRetimed )
+  {
+    const auto FrameRate = m_Client.GetFrameRate();
+    if( FrameRate.Result == ViconDataStreamSDK::CPP::Result::Success )
+    {
+      io_rContext.FrameRateHz = FrameRate.FrameRateHz;
+    }
+  }
+
+  const auto Timecode = m_Client.GetTimecode();
+  io_rContext.bHasTimecode = Timecode.Result == ViconDataStreamSDK::CPP::Result::Success && Timecode.SubFramesPerFrame > 0;
+  if( io_rContext.bHasTimecode )
+  {
+    LiveLinkTimeCodeFromViconTimeCode( Timecode, io_rContext.SceneTime );
+  }
+}
+
 EResult ViconStream::SetLightWeightEnabled( bool i_bEnabled )
 {
   if( i_bEnabled )
@@ -243,6 +278,92 @@ EResult ViconStream::Reconnect()
   return Connect( m_ServerIP, m_bRetimed, m_bLogOutput );
 }
 
+void ViconStream::SetConnectionTimeout( unsigned int i_TimeoutMs )
+{
+  if( m_Client.SetConnectionTimeout( i_TimeoutMs ).Result != ViconDataStreamSDK::CPP::Result::Success )
+  {
+    UE_LOG( LogViconStream, Warning, TEXT( "Failed to set connection timeout to %u ms" ), i_TimeoutMs );
+  }
+}
+
+int32 ViconStream::ProbeServers( const TArray< FString >& i_rServers, unsigned int i_TimeoutMs, const FThreadSafeBool& i_rStop )
+{
+  // Shared with the probes, which may still be winding down after we return
+  class FProbeState
+  {
+  public:
+    std::atomic< int32 > Winner{ INDEX_NONE };
+    std::atomic< int32 > Remaining{ 0 };
+    // Set when the caller gives up waiting, so the probes stop too
+    std::atomic< bool > bAbandoned{ false };
+    FEventRef Finished{ EEventMode::ManualReset };
+  };
+  TSharedRef< FProbeState, ESPMode::ThreadSafe > State = MakeShared< FProbeState, ESPMode::ThreadSafe >();
+  State->Remaining = i_rServers.Num();
+
+  for( int32 ServerIndex = 0; ServerIndex < i_rServers.Num(); ++ServerIndex )
+  {
+    // Connect blocks, so each probe needs a thread of its own rather than a task graph worker
+    Async( EAsyncExecution::Thread, [ State, ServerIndex, Server = i_rServers[ ServerIndex ], i_TimeoutMs ]()
+    {
+      const uint64 StartCycles = FPlatformTime::Cycles64();
+      const double Deadline = FPlatformTime::Seconds() + i_TimeoutMs / 1000.0;
+      bool bGotFrame = false;
+
+      ViconDataStreamSDK::CPP::Client Probe;
+      Probe.SetConnectionTimeout( i_TimeoutMs );
+      if( Probe.Connect( TCHAR_TO_UTF8( *Server ) ).Result == ViconDataStreamSDK::CPP::Result::Success )
+      {
+        // Stop as soon as another probe has won
+        while( State->Winner == INDEX_NONE && !State->bAbandoned && FPlatformTime::Seconds() < Deadline )
+        {
+          if( Probe.GetFrame().Result == ViconDataStreamSDK::CPP::Result::Success )
+          {
+            bGotFrame = true;
+            break;
+          }
+          FPlatformProcess::Sleep( 0.001f );
+        }
+      }
+      const double RoundTripMs = FPlatformTime::ToMilliseconds64( FPlatformTime::Cycles64() - StartCycles );
+
+      int32 NoWinner = INDEX_NONE;
+      const bool bWon = bGotFrame && State->Winner.compare_exchange_strong( NoWinner, ServerIndex );
+      if( bGotFrame )
+      {
+        UE_LOG( LogViconStream, Display, TEXT( "Probe of %s: first frame after %.1f ms%s" ), *Server, RoundTripMs, bWon ? TEXT( ", selected" ) : TEXT( "" ) );
+      }
+      else
+      {
+        UE_LOG( LogViconStream, Display, TEXT( "Probe of %s: no frame after %.1f ms" ), *Server, RoundTripMs );
+      }
+
+      if( bWon || --State->Remaining == 0 )
+      {
+        State->Finished->Trigger();
+      }
+
+      if( Probe.IsConnected().Connected )
+      {
+        Probe.Disconnect();
+      }
+    } );
+  }
+
+  // Every probe gives up after its timeout, the margin covers thread start up and tear down. Wait in slices
+  // so that a stop request is not held up by the probes.
+  const double Deadline = FPlatformTime::Seconds() + ( i_TimeoutMs * 2 + 100 ) / 1000.0;
+  while( !State->Finished->Wait( 10 ) )
+  {
+    if( i_rStop || FPlatformTime::Seconds() >= Deadline )
+    {
+      State->bAbandoned = true;
+      return INDEX_NONE;
+    }
+  }
+  return State->Winner;
+}
+
 EResult ViconStream::GetFrame()
 {
   if( m_bRetimed )
@@ -285,6 +406,7 @@ EResult ViconStream::SetOffset( float Offset )
 void ViconStream::SetUseScaling( bool i_bUseScaling )
 {
   m_bUseScaling = i_bUseScaling;
+  m_SegmentConverters = FViconPoseKernel::SelectSegmentConverters( i_bUseScaling );
 }
 
 EResult ViconStream::SetSubjectFilter( const FString& i_rSubjectFilter )
@@ -372,13 +494,13 @@ EResult ViconStream::GetSegmentCountForSubject( const std::string& i_rSubjectNme
   return EResult::EError;
 }
 
-EResult ViconStream::GetSegmentNameForSubject( const std::string& i_rSubjectNme, int Index, FString& o_rSegName ) const
+EResult ViconStream::GetSegmentNameForSubject( const std::string& i_rSubjectNme, int Index, FViconNameId& o_rSegName ) const
 {
   const ViconDataStreamSDK::CPP::Output_GetSegmentName& Result = m_pClient->GetSegmentName( i_rSubjectNme, Index );
 
   if( Result.Result == ViconDataStreamSDK::CPP::Result::Success )
   {
-    o_rSegName = std::string( Result.SegmentName ).c_str();
+    o_rSegName = FViconNamePool::Get().Intern( std::string( Result.SegmentName ) );
     return EResult::ESuccess;
   }
 
@@ -389,7 +511,7 @@ EResult ViconStream::GetSegmentNameForSubject( const std::string& i_rSubjectNme,
   return EResult::EError;
 }
 
-EResult ViconStream::GetSegmentParentNameForSubject( const std::string& i_rSubjectName, const std::string& i_rSegName, FString& o_rSegName ) const
+EResult ViconStream::GetSegmentParentNameForSubject( const std::string& i_rSubjectName, const std::string& i_rSegName, FViconNameId& o_rSegName ) const
 {
   // We've removed use of local string copies here as it seems to cause corruption when run as a packaged build. There may be a bug in the Datastream String class that
   // will take further investigation.
@@ -402,96 +524,58 @@ EResult ViconStream::GetSegmentParentNameForSubject( const std::string& i_rSubje
 
   if( Result.Result == ViconDataStreamSDK::CPP::Result::Success || Result.Result == ViconDataStreamSDK::CPP::Result::Unknown )
   {
-    o_rSegName = std::string( Result.SegmentName ).c_str();
+    o_rSegName = FViconNamePool::Get().Intern( std::string( Result.SegmentName ) );
     return EResult::ESuccess;
   }
 
   return EResult::EError;
 }
 
-EResult ViconStream::GetSegmentLocalPose( const std::string& i_rSubjectName, const std::string& i_rSegmentName, FTransform& o_rPose )
+EResult ViconStream::CaptureSegment( const std::string& i_rSubjectName, const std::string& i_rSegmentName, FViconRawSegment& o_rSegment )
 {
-  // Scale
-
-  const ViconDataStreamSDK::CPP::Output_GetSegmentStaticScale& SegScale = m_pClient->GetSegmentStaticScale( i_rSubjectName, i_rSegmentName );
-  if( m_bUseScaling && SegScale.Result == ViconDataStreamSDK::CPP::Result::Success )
-  {
-    UE_LOG( LogViconStream, Log, TEXT( "Using subject scale of %f %f %f" ), SegScale.Scale[ 0 ], SegScale.Scale[ 1 ], SegScale.Scale[ 2 ] );
-    o_rPose.SetScale3D( FVector( SegScale.Scale[ 0 ], SegScale.Scale[ 1 ], SegScale.Scale[ 2 ] ) );
-  }
-  else
-  {
-    // TODO: If we want to scale per bone correctly, we will have to apply the inverse of the parents transformation first.
-    // We will probably do this at the server side when we set the transformations; i.e. scale is relative to its parent scale.
-    o_rPose.SetScale3D( FVector( 1.0, 1.0, 1.0 ) );
-  }
-
   //Translation
   const ViconDataStreamSDK::CPP::Output_GetSegmentLocalTranslation& SegLocalTranslation = m_pClient->GetSegmentLocalTranslation( i_rSubjectName, i_rSegmentName );
-  std::pair< std::string, std::string > CachedSegment( i_rSubjectName, i_rSegmentName );
-
-  if( SegLocalTranslation.Result != ViconDataStreamSDK::CPP::Result::Success || SegLocalTranslation.Occluded )
-  {
-    if( m_CachedSubject.count( CachedSegment ) )
-    {
-      o_rPose = m_CachedSubject[ CachedSegment ];
-      UE_LOG( LogViconStream, Log, TEXT( "Segment is occluded, using cached data" ) );
-      return ESuccess;
-    }
-    else
-    {
-      UE_LOG( LogViconStream, Log, TEXT( "Segment is occluded and there's no cached data either" ) );
-      o_rPose.SetTranslation( FVector( 0, 0, 0 ) );
-      return EError;
-    }
-  }
-  else
-  {
-    FVector Translation = FVector( SegLocalTranslation.Translation[ 0 ], -SegLocalTranslation.Translation[ 1 ], SegLocalTranslation.Translation[ 2 ] ) * 0.1;
-    FVector SegmentScale;
-    FVector ScaledTranslation;
-    if( m_bUseScaling && GetSegmentScale( i_rSubjectName, i_rSegmentName, SegmentScale ) == EResult::ESuccess )
-    {
-      for( unsigned int i = 0; i < 3; ++i )
-      {
-        if( SegmentScale[ i ] != 0 )
-        {
-          ScaledTranslation[ i ] = Translation[ i ] / SegmentScale[ i ];
-        }
-        else
-        {
-          ScaledTranslation[ i ] = Translation[ i ];
-        }
-      }
-    }
-    else
-    {
-      ScaledTranslation = Translation;
-    }
-
-    o_rPose.SetTranslation( ScaledTranslation );
-  }
+  o_rSegment.bTranslationValid = ( SegLocalTranslation.Result == ViconDataStreamSDK::CPP::Result::Success && !SegLocalTranslation.Occluded );
+  FMemory::Memcpy( o_rSegment.Translation, SegLocalTranslation.Translation, sizeof( o_rSegment.Translation ) );
 
   //Rotation
   const ViconDataStreamSDK::CPP::Output_GetSegmentLocalRotationQuaternion& SegLocalRotation = m_pClient->GetSegmentLocalRotationQuaternion( i_rSubjectName, i_rSegmentName );
-  if( SegLocalRotation.Rotation[ 3 ] == 0 )
+  o_rSegment.bRotationValid = ( SegLocalRotation.Result == ViconDataStreamSDK::CPP::Result::Success && !SegLocalRotation.Occluded );
+  FMemory::Memcpy( o_rSegment.Rotation, SegLocalRotation.Rotation, sizeof( o_rSegment.Rotation ) );
+
+  return ESuccess;
+}
+
+void ViconStream::GetHierarchyScales( const std::string& i_rSubjectName, const TArray< FViconNameId >& i_rBoneNames, TArray< FVector >& o_rScales )
+{
+  const FViconNamePool& rPool = FViconNamePool::Get();
+  o_rScales.SetNumUninitialized( i_rBoneNames.Num() );
+  for( int32 BoneIndex = 0; BoneIndex < i_rBoneNames.Num(); ++BoneIndex )
   {
-    // todo: work out where the (0,0,0,0) is from.
-    return EError;
+    GetSegmentScale( i_rSubjectName, rPool.GetUtf8( i_rBoneNames[ BoneIndex ] ), o_rScales[ BoneIndex ] );
   }
-  if( SegLocalRotation.Result != ViconDataStreamSDK::CPP::Result::Success || SegLocalRotation.Occluded )
+}
+
+void ViconStream::GetStaticScales( const std::string& i_rSubjectName, const TArray< FViconNameId >& i_rBoneNames, TArray< FVector >& o_rScales )
+{
+  const FViconNamePool& rPool = FViconNamePool::Get();
+  o_rScales.SetNumUninitialized( i_rBoneNames.Num() );
+  for( int32 BoneIndex = 0; BoneIndex < i_rBoneNames.Num(); ++BoneIndex )
   {
-    // shouldn't hit here
-    return EError;
+    GetSegmentStaticScale( i_rSubjectName, rPool.GetUtf8( i_rBoneNames[ BoneIndex ] ), o_rScales[ BoneIndex ] );
   }
-  else
+}
+
+bool ViconStream::GetSegmentStaticScale( const std::string& i_rSubjectName, const std::string& i_rSegmentName, FVector& o_rScale )
+{
+  const ViconDataStreamSDK::CPP::Output_GetSegmentStaticScale& SegScale = m_pClient->GetSegmentStaticScale( i_rSubjectName, i_rSegmentName );
+  if( SegScale.Result != ViconDataStreamSDK::CPP::Result::Success )
   {
-    o_rPose.SetRotation( FQuat( -SegLocalRotation.Rotation[ 0 ], SegLocalRotation.Rotation[ 1 ], -SegLocalRotation.Rotation[ 2 ], SegLocalRotation.Rotation[ 3 ] ) );
+    o_rScale = FVector::OneVector;
+    return false;
   }
-
-  m_CachedSubject[ CachedSegment ] = o_rPose;
-
-  return ESuccess;
+  o_rScale = FVector( SegScale.Scale[ 0 ], SegScale.Scale[ 1 ], SegScale.Scale[ 2 ] );
+  return true;
 }
 
 EResult ViconStream::GetSubjectCount( int& o_rCount ) const
@@ -516,7 +600,7 @@ EResult ViconStream::GetSubjectName( int Index, FString& o_rName ) const
   return EResult::EError;
 }
 
-EResult ViconStream::GetSubjectNames( TArray< FString >& SubjectNames )
+EResult ViconStream::GetSubjectNames( TArray< FViconNameId >& SubjectNames )
 {
   int SubjectCount;
   EResult CountResult = GetSubjectCount( SubjectCount );
@@ -526,15 +610,16 @@ EResult ViconStream::GetSubjectNames( TArray< FString >& SubjectNames )
     return EResult::EError;
   }
 
+  // Interned straight from the SDK's UTF-8, rather than converted to FString every frame
+  FViconNamePool& rPool = FViconNamePool::Get();
   for( int SubjectIndex = 0; SubjectIndex < SubjectCount; ++SubjectIndex )
   {
-    FString SubjectName;
-    EResult SubjectNameResult = GetSubjectName( SubjectIndex, SubjectName );
-    if( SubjectNameResult != EResult::ESuccess )
+    const ViconDataStreamSDK::CPP::Output_GetSubjectName& Result = m_pClient->GetSubjectName( SubjectIndex );
+    if( Result.Result != ViconDataStreamSDK::CPP::Result::Success )
     {
       return EResult::EError;
     }
-    SubjectNames.Emplace( SubjectName );
+    SubjectNames.Emplace( rPool.Intern( std::string( Result.SubjectName ) ) );
   }
   return EResult::ESuccess;
 }
@@ -548,10 +633,18 @@ EResult ViconStream::GetRootPose( const std::string& i_rSubjectName, FVector& o_
     return EResult::EError;
   }
 
-  ViconDataStreamSDK::CPP::String RootName = NameResult.SegmentName;
+  const std::string RootName = NameResult.SegmentName;
   FTransform Pose;
 
-  EResult Result = GetSegmentLocalPose( i_rSubjectName, std::string( RootName ).c_str(), Pose );
+  FViconRawSegment RawSegment;
+  CaptureSegment( i_rSubjectName, RootName, RawSegment );
+  FVector StaticScale;
+  RawSegment.bHasStaticScale = GetSegmentStaticScale( i_rSubjectName, RootName, StaticScale );
+  RawSegment.StaticScale[ 0 ] = StaticScale.X;
+  RawSegment.StaticScale[ 1 ] = StaticScale.Y;
+  RawSegment.StaticScale[ 2 ] = StaticScale.Z;
+  // The root has no hierarchy scale, so it converts like a rigid body. The pose is reported without axis mapping.
+  const EResult Result = m_SegmentConverters.RigidBody[ 0 ]( MakeArrayView( &RawSegment, 1 ), nullptr, nullptr, MakeArrayView( &Pose, 1 ) ) == INDEX_NONE ? EResult::ESuccess : EResult::EError;
 
   o_rPosition = Pose.GetTranslation();
   o_rOrientation = Pose.GetRotation();
@@ -575,7 +668,7 @@ EResult ViconStream::GetDynamicCameraCount( int& o_rCount ) const
   return EResult::EError;
 }
 
-EResult ViconStream::GetDynamicCameraNames( TSet< FString >& o_rNameList ) const
+EResult ViconStream::GetDynamicCameraNames( TSet< FViconNameId >& o_rNameList ) const
 {
   if( m_bRetimed )
   {
@@ -596,12 +689,12 @@ EResult ViconStream::GetDynamicCameraNames( TSet< FString >& o_rNameList ) const
     }
 
 
-    o_rNameList.Add( std::string( CameraNameResult.CameraName ).c_str() );
+    o_rNameList.Add( FViconNamePool::Get().Intern( std::string( CameraNameResult.CameraName ) ) );
   }
   return EResult::ESuccess;
 }
 
-EResult ViconStream::GetVideoCameraNames( TSet< FString >& o_rNameList ) const
+EResult ViconStream::GetVideoCameraNames( TSet< FViconNameId >& o_rNameList ) const
 {
   if( m_bRetimed )
   {
@@ -616,13 +709,13 @@ EResult ViconStream::GetVideoCameraNames( TSet< FString >& o_rNameList ) const
 
     if( m_Client.GetIsVideoCamera( CameraNameResult.CameraName ).IsVideoCamera )
     {
-      o_rNameList.Add( std::string( CameraNameResult.CameraName ).c_str() );
+      o_rNameList.Add( FViconNamePool::Get().Intern( std::string( CameraNameResult.CameraName ) ) );
     }
   }
   return EResult::ESuccess;
 }
 
-EResult ViconStream::GetCameraTransformFrameData( const std::string& i_rCameraName, FLiveLinkTransformFrameData& OutSubject )
+EResult ViconStream::CaptureCamera( const std::string& i_rCameraName, FViconRawCamera& o_rCamera )
 {
   if( m_bRetimed )
   {
@@ -635,46 +728,15 @@ EResult ViconStream::GetCameraTransformFrameData( const std::string& i_rCameraNa
   {
     return EResult::EError;
   }
-  // mapping to unreal by mirroring xz plane
-  FVector Translation = FVector( TranslationResult.Translation[ 0 ], -TranslationResult.Translation[ 1 ], TranslationResult.Translation[ 2 ] ) * 0.1;
-  OutSubject.Transform.SetTranslation( Translation );
+  FMemory::Memcpy( o_rCamera.Translation, TranslationResult.Translation, sizeof( o_rCamera.Translation ) );
 
   auto RotationResult = m_Client.GetCameraGlobalRotationQuaternion( i_rCameraName );
   if( RotationResult.Result != ViconDataStreamSDK::CPP::Result::Success )
   {
     return EResult::EError;
   }
-  FQuat Rotation = FQuat( -RotationResult.Rotation[ 0 ], RotationResult.Rotation[ 1 ], -RotationResult.Rotation[ 2 ], RotationResult.Rotation[ 3 ] );
-  OutSubject.Transform.SetRotation( Rotation );
+  FMemory::Memcpy( o_rCamera.Rotation, RotationResult.Rotation, sizeof( o_rCamera.Rotation ) );
 
-  // server axis mapping
-  if( IsViconServerYup() )
-  {
-    OutSubject.Transform = OutSubject.Transform * s_YUpRotation;
-  }
-
-  // Extra camera rotation as it's ( right, down, forward )in data stream
-  FQuat CameraRotation = OutSubject.Transform.GetRotation();
-  FMatrix RotMatrix( FVector::ZAxisVector, FVector::XAxisVector, FVector::YAxisVector, FVector::ZeroVector );
-  OutSubject.Transform.SetRotation( FQuat( CameraRotation * RotMatrix ) );
-
-  return EResult::ESuccess;
-}
-
-EResult ViconStream::GetLensStaticData( const std::string& i_rCameraName, FLiveLinkLensStaticData& LensStaticData )
-{
-  LensStaticData.LensModel = UViconLensModel::LensModelName;
-  return ESuccess;
-}
-
-EResult ViconStream::GetLensFrameData( const std::string& i_rCameraName, FLiveLinkLensFrameData& LensFrameData )
-{
-  // not available in retimed data
-  if( m_bRetimed )
-  {
-    UE_LOG( LogViconStream, Error, TEXT( "Camera data doesn't support retime mode." ) );
-    return EResult::EError;
-  }
   //
   auto ResolutionResult = m_Client.GetCameraResolution( i_rCameraName );
   if( ResolutionResult.Result != ViconDataStreamSDK::CPP::Result::Success )
@@ -682,7 +744,8 @@ EResult ViconStream::GetLensFrameData( const std::string& i_rCameraName, FLiveLi
     UE_LOG( LogViconStream, Error, TEXT( "Couldn't get camera resolution." ) );
     return EResult::EError;
   }
-  FVector2D Resolution = FVector2D( ResolutionResult.ResolutionX, ResolutionResult.ResolutionY );
+  o_rCamera.Resolution[ 0 ] = ResolutionResult.ResolutionX;
+  o_rCamera.Resolution[ 1 ] = ResolutionResult.ResolutionY;
 
   //
   auto FocalLengthResult = m_Client.GetCameraFocalLength( i_rCameraName );
@@ -691,7 +754,7 @@ EResult ViconStream::GetLensFrameData( const std::string& i_rCameraName, FLiveLi
     UE_LOG( LogViconStream, Error, TEXT( "Couldn't get camera focal length." ) );
     return EResult::EError;
   }
-  auto FocalLength = FocalLengthResult.FocalLength;
+  o_rCamera.FocalLength = FocalLengthResult.FocalLength;
 
   // param
   auto ParamResult = m_Client.GetCameraLensParameters( i_rCameraName );
@@ -700,6 +763,10 @@ EResult ViconStream::GetLensFrameData( const std::string& i_rCameraName, FLiveLi
     UE_LOG( LogViconStream, Error, TEXT( "Couldn't get camera lens parameters." ) );
     return EResult::EError;
   }
+  for( int32 i = 0; i < 3; ++i )
+  {
+    o_rCamera.LensParameters[ i ] = ParamResult.LensParameters[ i ];
+  }
 
   // principal point
   auto PrinciplePointResult = m_Client.GetCameraPrincipalPoint( i_rCameraName );
@@ -708,43 +775,67 @@ EResult ViconStream::GetLensFrameData( const std::string& i_rCameraName, FLiveLi
     UE_LOG( LogViconStream, Error, TEXT( "Couldn't get camera principal point." ) );
     return EResult::EError;
   }
+  o_rCamera.PrincipalPoint[ 0 ] = PrinciplePointResult.PrincipalPointX;
+  o_rCamera.PrincipalPoint[ 1 ] = PrinciplePointResult.PrincipalPointY;
+
+  return EResult::ESuccess;
+}
+
+EResult ViconStream::GetCameraTransformFrameData( const FViconFrameContext& i_rContext, const FViconRawCamera& i_rCamera, FLiveLinkTransformFrameData& OutSubject ) const
+{
+  // mapping to unreal by mirroring xz plane
+  FVector Translation = FVector( i_rCamera.Translation[ 0 ], -i_rCamera.Translation[ 1 ], i_rCamera.Translation[ 2 ] ) * 0.1;
+  OutSubject.Transform.SetTranslation( Translation );
+
+  FQuat Rotation = FQuat( -i_rCamera.Rotation[ 0 ], i_rCamera.Rotation[ 1 ], -i_rCamera.Rotation[ 2 ], i_rCamera.Rotation[ 3 ] );
+  OutSubject.Transform.SetRotation( Rotation );
+
+  // server axis mapping
+  if( i_rContext.bYUp )
+  {
+    OutSubject.Transform = OutSubject.Transform * FViconPoseKernel::YUpRotation;
+  }
+
+  // Extra camera rotation as it's ( right, down, forward )in data stream
+  FQuat CameraRotation = OutSubject.Transform.GetRotation();
+  FMatrix RotMatrix( FVector::ZAxisVector, FVector::XAxisVector, FVector::YAxisVector, FVector::ZeroVector );
+  OutSubject.Transform.SetRotation( FQuat( CameraRotation * RotMatrix ) );
+
+  return EResult::ESuccess;
+}
+
+EResult ViconStream::GetLensStaticData( const std::string& i_rCameraName, FLiveLinkLensStaticData& LensStaticData )
+{
+  LensStaticData.LensModel = UViconLensModel::LensModelName;
+  return ESuccess;
+}
+
+EResult ViconStream::GetLensFrameData( const FViconFrameContext& i_rContext, const FViconRawCamera& i_rCamera, FLiveLinkLensFrameData& LensFrameData ) const
+{
+  FVector2D Resolution = FVector2D( i_rCamera.Resolution[ 0 ], i_rCamera.Resolution[ 1 ] );
+  auto FocalLength = i_rCamera.FocalLength;
 
   // adjust it to the unreal spherical modal
   float ViconFocalP2 = FMath::Pow( FocalLength, 2 );
   float ViconFocalP4 = FMath::Pow( FocalLength, 4 );
   float ViconFocalP6 = FMath::Pow( FocalLength, 6 );
 
-  LensFrameData.DistortionParameters = {(float)ParamResult.LensParameters[ 0 ] * ViconFocalP2,
-                                        (float)ParamResult.LensParameters[ 1 ] * ViconFocalP4,
-                                        (float)ParamResult.LensParameters[ 2 ] * ViconFocalP6};
+  LensFrameData.DistortionParameters = {(float)i_rCamera.LensParameters[ 0 ] * ViconFocalP2,
+                                        (float)i_rCamera.LensParameters[ 1 ] * ViconFocalP4,
+                                        (float)i_rCamera.LensParameters[ 2 ] * ViconFocalP6};
 
-  LensFrameData.PrincipalPoint = FVector2D( PrinciplePointResult.PrincipalPointX, PrinciplePointResult.PrincipalPointY ) / Resolution;
+  LensFrameData.PrincipalPoint = FVector2D( i_rCamera.PrincipalPoint[ 0 ], i_rCamera.PrincipalPoint[ 1 ] ) / Resolution;
   LensFrameData.FxFy = FVector2D( FocalLength / Resolution.X, FocalLength / Resolution.Y );
 
   // Add timecode to metadata
-  ViconDataStreamSDK::CPP::Output_GetTimecode GetTimeCodeResult = m_Client.GetTimecode();
-  if( GetTimeCodeResult.Result == ViconDataStreamSDK::CPP::Result::Success && GetTimeCodeResult.SubFramesPerFrame > 0 )
+  if( i_rContext.bHasTimecode )
   {
-    LiveLinkTimeCodeFromViconTimeCode( GetTimeCodeResult, LensFrameData.MetaData.SceneTime );
+    LensFrameData.MetaData.SceneTime = i_rContext.SceneTime;
   }
 
   return EResult::ESuccess;
 }
 
-FVector ViconStream::HandleMarker(const double i_Translation[3])
-{
-  FTransform MarkerTransformation;
-  MarkerTransformation.SetRotation(FQuat::Identity);
-  // 0.1 for mm->cm conversion
-  MarkerTransformation.SetTranslation(FVector(i_Translation[0], -i_Translation[1], i_Translation[2]) * 0.1);
-  if (IsViconServerYup())
-  {
-    MarkerTransformation = MarkerTransformation * s_YUpRotation;
-  }
-  auto Marker = MarkerTransformation.GetTranslation();
-  return FVector { Marker.X, Marker.Y, Marker.Z };
-}
-
 EResult ViconStream::GetUnlabeledMarkerCount(unsigned int& o_rCount)
 {
   o_rCount = 0;
@@ -769,11 +860,19 @@ EResult ViconStream::GetLabeledMarkerCount(unsigned int& o_rCount)
   return Result.Result ? EResult::ESuccess : EResult::EError;
 }
 
-EResult ViconStream::GetLabeledMarkers( TArrayView< float >& o_rMarkerList )
+EResult ViconStream::CaptureLabeledMarkers( FViconRawMarkerSet& o_rMarkers )
 {
+  o_rMarkers.Reset();
+  if( GetLabeledMarkerCount( o_rMarkers.Count ) != EResult::ESuccess )
+  {
+    return EResult::EError;
+  }
+  o_rMarkers.bCountValid = true;
+
   // not available in retimed data
-  if (!m_Client.IsMarkerDataEnabled().Enabled)
+  if( !m_Client.IsMarkerDataEnabled().Enabled )
   {
+    o_rMarkers.bTranslationsValid = true;
     return EResult::ESuccess;
   }
   if( m_bRetimed )
@@ -782,23 +881,29 @@ EResult ViconStream::GetLabeledMarkers( TArrayView< float >& o_rMarkerList )
     return EResult::EError;
   }
 
-  unsigned int MarkerCount = m_Client.GetLabeledMarkerCount().MarkerCount;
-  for( unsigned int MarkerIndex = 0; MarkerIndex < MarkerCount; ++MarkerIndex )
+  o_rMarkers.Translations.SetNumUninitialized( o_rMarkers.Count * 3 );
+  for( unsigned int MarkerIndex = 0; MarkerIndex < o_rMarkers.Count; ++MarkerIndex )
   {
     const auto Result = m_Client.GetLabeledMarkerGlobalTranslation( MarkerIndex );
-    const auto MarkerPose = HandleMarker(Result.Translation);
-    o_rMarkerList[MarkerIndex*3] = MarkerPose[0];
-    o_rMarkerList[MarkerIndex*3+1]= MarkerPose[1];
-    o_rMarkerList[MarkerIndex*3+2] = MarkerPose[2];
+    FMemory::Memcpy( &o_rMarkers.Translations[ MarkerIndex * 3 ], Result.Translation, sizeof( Result.Translation ) );
   }
+  o_rMarkers.bTranslationsValid = true;
   return EResult::ESuccess;
 }
 
-EResult ViconStream::GetUnlabeledMarkers(TArrayView < float > & o_rMarkerList)
+EResult ViconStream::CaptureUnlabeledMarkers( FViconRawMarkerSet& o_rMarkers )
 {
+  o_rMarkers.Reset();
+  if( GetUnlabeledMarkerCount( o_rMarkers.Count ) != EResult::ESuccess )
+  {
+    return EResult::EError;
+  }
+  o_rMarkers.bCountValid = true;
+
   // not available in retimed data
-  if (!m_Client.IsUnlabeledMarkerDataEnabled().Enabled)
+  if( !m_Client.IsUnlabeledMarkerDataEnabled().Enabled )
   {
+    o_rMarkers.bTranslationsValid = true;
     return EResult::ESuccess;
   }
   if( m_bRetimed )
@@ -807,18 +912,22 @@ EResult ViconStream::GetUnlabeledMarkers(TArrayView < float > & o_rMarkerList)
     return EResult::EError;
   }
 
-  unsigned int MarkerCount = m_Client.GetUnlabeledMarkerCount().MarkerCount;
-  for( unsigned int MarkerIndex = 0; MarkerIndex < MarkerCount; ++MarkerIndex )
+  o_rMarkers.Translations.SetNumUninitialized( o_rMarkers.Count * 3 );
+  for( unsigned int MarkerIndex = 0; MarkerIndex < o_rMarkers.Count; ++MarkerIndex )
   {
-    const auto Result = m_Client.GetUnlabeledMarkerGlobalTranslation(MarkerIndex);
-    const auto MarkerPose = HandleMarker(Result.Translation);
-    o_rMarkerList[MarkerIndex*3] = MarkerPose[0];
-    o_rMarkerList[MarkerIndex*3+1]= MarkerPose[1];
-    o_rMarkerList[MarkerIndex*3+2] = MarkerPose[2];
+    const auto Result = m_Client.GetUnlabeledMarkerGlobalTranslation( MarkerIndex );
+    FMemory::Memcpy( &o_rMarkers.Translations[ MarkerIndex * 3 ], Result.Translation, sizeof( Result.Translation ) );
   }
+  o_rMarkers.bTranslationsValid = true;
   return EResult::ESuccess;
 }
 
+void ViconStream::GetMarkers( const FViconFrameContext& i_rContext, const FViconRawMarkerSet& i_rMarkers, TArrayView< float >& o_rMarkerList ) const
+{
+  const int32 MarkerCount = FMath::Min( i_rMarkers.Translations.Num() / 3, o_rMarkerList.Num() / 3 );
+  FViconPoseKernel::SelectMarkerConverter( i_rContext.bYUp )( i_rMarkers.Translations.GetData(), MarkerCount, o_rMarkerList.GetData() );
+}
+
 EResult ViconStream::GetMarkerCountForSubject(const std::string& i_rSubjectName, unsigned int& o_rCount)
 {
   o_rCount = 0;
@@ -831,7 +940,7 @@ EResult ViconStream::GetMarkerCountForSubject(const std::string& i_rSubjectName,
   return Result.Result ? EResult::ESuccess : EResult::EError;
 }
 
-EResult ViconStream::GetMarkerNamesForSubject(const std::string& i_rSubjectName, TArray<std::string>& o_rNames)
+EResult ViconStream::GetMarkerNamesForSubject(const std::string& i_rSubjectName, TArray<FViconNameId>& o_rNames)
 {
   o_rNames.Empty();
   if (!m_Client.IsMarkerDataEnabled().Enabled)
@@ -857,15 +966,14 @@ EResult ViconStream::GetMarkerNamesForSubject(const std::string& i_rSubjectName,
     {
       return EResult::EError;
     }
-    o_rNames.Emplace(Result.MarkerName);
+    o_rNames.Emplace(FViconNamePool::Get().Intern(std::string(Result.MarkerName)));
   }
   return EResult::ESuccess;
 }
 
-EResult ViconStream::GetMarkersForSubject(const std::string& i_rSubjectName, const TArray<std::string>& i_rMarkerNames, TArray<float>& o_rMarkerValues) 
+EResult ViconStream::CaptureMarkersForSubject( FViconRawSubject& io_rSubject )
 {
-  o_rMarkerValues.Empty();
-  o_rMarkerValues.Emplace(static_cast<float>(i_rMarkerNames.Num()));
+  io_rSubject.MarkerTranslations.Reset();
   if (!m_Client.IsMarkerDataEnabled().Enabled)
   {
     return EResult::ESuccess;
@@ -876,50 +984,80 @@ EResult ViconStream::GetMarkersForSubject(const std::string& i_rSubjectName, con
     return EResult::EError;
   }
 
-  for (const std::string& rMarkerName: i_rMarkerNames)
+  const FViconNamePool& rPool = FViconNamePool::Get();
+  for (const FViconNameId MarkerName: io_rSubject.Schema->Template->Markers)
   {
-    const auto TransformResult = m_Client.GetMarkerGlobalTranslation(i_rSubjectName, rMarkerName);
+    const auto TransformResult = m_Client.GetMarkerGlobalTranslation(io_rSubject.Name->Utf8(), rPool.GetUtf8(MarkerName));
     if (!TransformResult.Result)
     {
       return EResult::EError;
     }
-    const FVector MarkerTranslation = HandleMarker(TransformResult.Translation);
-    o_rMarkerValues.Emplace(MarkerTranslation.X);
-    o_rMarkerValues.Emplace(MarkerTranslation.Y);
-    o_rMarkerValues.Emplace(MarkerTranslation.Z);
+    io_rSubject.MarkerTranslations.Append(TransformResult.Translation, 3);
   }
   return EResult::ESuccess;
 }
 
-bool ViconStream::GetPoseForSubject( 
-  const std::string& InName, const TArray< std::string >& BoneNames, const TArray<std::string>& MarkerNames, FLiveLinkFrameDataStruct& OutSubject )
+EResult ViconStream::GetMarkersForSubject(const FViconFrameContext& i_rContext, const FViconRawSubject& i_rSubject, TArray<float>& o_rMarkerValues) const
 {
-  ViconDataStreamSDK::CPP::Output_GetSegmentCount SegmentCount = m_pClient->GetSegmentCount( InName );
+  const int32 MarkerCount = i_rSubject.MarkerTranslations.Num() / 3;
+  o_rMarkerValues.SetNumUninitialized(1 + MarkerCount * 3);
+  o_rMarkerValues[0] = static_cast<float>(i_rSubject.Schema->Template->Markers.Num());
+  FViconPoseKernel::SelectMarkerConverter(i_rContext.bYUp)(i_rSubject.MarkerTranslations.GetData(), MarkerCount, o_rMarkerValues.GetData() + 1);
+  return i_rSubject.bMarkersValid ? EResult::ESuccess : EResult::EError;
+}
+
+bool ViconStream::CaptureSubject( FViconRawSubject& io_rSubject )
+{
+  const std::string& SubjectName = io_rSubject.Name->Utf8();
+  ViconDataStreamSDK::CPP::Output_GetSegmentCount SegmentCount = m_pClient->GetSegmentCount( SubjectName );
   if( SegmentCount.Result != ViconDataStreamSDK::CPP::Result::Success )
     return false;
+  io_rSubject.SegmentCount = SegmentCount.SegmentCount;
+
+  const FViconNamePool& rPool = FViconNamePool::Get();
+  const TArray< FViconNameId >& BoneNames = io_rSubject.Schema->Template->Bones;
+  const TArray< FVector >& StaticScales = io_rSubject.Schema->StaticScales;
+  const int32 Available = FMath::Min( static_cast< int32 >( SegmentCount.SegmentCount ), BoneNames.Num() );
+  io_rSubject.Segments.SetNum( Available, false );
+  for( int32 j = 0; j < Available; ++j )
+  {
+    FViconRawSegment& rSegment = io_rSubject.Segments[ j ];
+    CaptureSegment( SubjectName, rPool.GetUtf8( BoneNames[ j ] ), rSegment );
+    rSegment.bHasStaticScale = StaticScales.IsValidIndex( j );
+    const FVector StaticScale = rSegment.bHasStaticScale ? StaticScales[ j ] : FVector::OneVector;
+    rSegment.StaticScale[ 0 ] = StaticScale.X;
+    rSegment.StaticScale[ 1 ] = StaticScale.Y;
+    rSegment.StaticScale[ 2 ] = StaticScale.Z;
+  }
+
+  io_rSubject.bMarkersValid = ( CaptureMarkersForSubject( io_rSubject ) == EResult::ESuccess );
+  return true;
+}
+
+bool ViconStream::GetPoseForSubject( const FViconFrameContext& i_rContext, const FViconRawSubject& i_rSubject, FLiveLinkFrameDataStruct& OutSubject )
+{
+  const std::string& InName = i_rSubject.Name->Utf8();
+  const TArray< FViconNameId >& BoneNames = i_rSubject.Schema->Template->Bones;
+  const FVector* pHierarchyScales = i_rSubject.Schema->HierarchyScales.GetData();
+  FViconSubjectPoseCache* pPoseCache = i_rSubject.PoseCache.Get();
 
   // rigid body
-  if( SegmentCount.SegmentCount == 1 )
+  if( i_rSubject.SegmentCount == 1 )
   {
     FLiveLinkTransformFrameData& FrameData = *OutSubject.Cast< FLiveLinkTransformFrameData >();
     FTransform& Pose = FrameData.Transform;
-    if( GetSegmentLocalPose( InName, BoneNames[ 0 ], Pose ) != EResult::ESuccess )
+    if( m_SegmentConverters.RigidBody[ i_rContext.bYUp ]( i_rSubject.Segments, pHierarchyScales, pPoseCache, MakeArrayView( &Pose, 1 ) ) != INDEX_NONE )
     {
       UE_LOG( LogViconStream, Log, TEXT( "Failed to get Segment for %hs:%hs" ),
-              InName.c_str(), BoneNames[ 0 ].c_str() );
+              InName.c_str(), BoneNames.Num() > 0 ? FViconNamePool::Get().GetUtf8( BoneNames[ 0 ] ).c_str() : "" );
       return false;
     }
-    if( IsViconServerYup() )
-    {
-      Pose = Pose * s_YUpRotation;
-    }
 
-    ViconDataStreamSDK::CPP::Output_GetTimecode GetTimeCodeResult = m_Client.GetTimecode();
-    if( GetTimeCodeResult.Result == ViconDataStreamSDK::CPP::Result::Success && GetTimeCodeResult.SubFramesPerFrame > 0 )
+    if( i_rContext.bHasTimecode )
     {
-      LiveLinkTimeCodeFromViconTimeCode( GetTimeCodeResult, FrameData.MetaData.SceneTime );
+      FrameData.MetaData.SceneTime = i_rContext.SceneTime;
     }
-    GetMarkersForSubject(InName, MarkerNames, FrameData.PropertyValues);
+    GetMarkersForSubject(i_rContext, i_rSubject, FrameData.PropertyValues);
     return true;
   }
 
@@ -927,39 +1065,27 @@ bool ViconStream::GetPoseForSubject(
   FLiveLinkAnimationFrameData& FrameData = *OutSubject.Cast< FLiveLinkAnimationFrameData >();
   TArray< FTransform >& OutPose = FrameData.Transforms;
 
-  OutPose.SetNumZeroed( SegmentCount.SegmentCount );
+  OutPose.SetNumZeroed( i_rSubject.SegmentCount );
 
   unsigned int BoneCount = (unsigned int)BoneNames.Num();
-  if( SegmentCount.SegmentCount != BoneCount )
+  if( i_rSubject.SegmentCount != BoneCount )
   {
     UE_LOG( LogViconStream, Warning, TEXT( "Vicon segments has %d segments while Livelink skeleton has %d bones" ),
-            SegmentCount.SegmentCount, BoneCount );
-  }
-  unsigned int Available = SegmentCount.SegmentCount < BoneCount ? SegmentCount.SegmentCount : BoneCount;
-  for( unsigned int j = 0; j < Available; ++j )
-  {
-    FTransform Trans = OutPose[ j ];
-    if( GetSegmentLocalPose( InName, BoneNames[ j ], Trans ) != EResult::ESuccess )
-    {
-      UE_LOG( LogViconStream, Log, TEXT( "Failed to get Segment for %hs:%hs" ),
-              InName.c_str(), BoneNames[ j ].c_str() );
-      return false;
-    }
-
-    OutPose[ j ] = Trans;
+            i_rSubject.SegmentCount, BoneCount );
   }
-
-  if( IsViconServerYup() )
+  const int32 FailedBone = m_SegmentConverters.Skeleton[ i_rContext.bYUp ]( i_rSubject.Segments, pHierarchyScales, pPoseCache, OutPose );
+  if( FailedBone != INDEX_NONE )
   {
-    OutPose[ 0 ] = OutPose[ 0 ] * s_YUpRotation;
+    UE_LOG( LogViconStream, Log, TEXT( "Failed to get Segment for %hs:%hs" ),
+            InName.c_str(), FViconNamePool::Get().GetUtf8( BoneNames[ FailedBone ] ).c_str() );
+    return false;
   }
 
-  ViconDataStreamSDK::CPP::Output_GetTimecode GetTimeCodeResult = m_Client.GetTimecode();
-  if( GetTimeCodeResult.Result == ViconDataStreamSDK::CPP::Result::Success && GetTimeCodeResult.SubFramesPerFrame > 0 )
+  if( i_rContext.bHasTimecode )
   {
-    LiveLinkTimeCodeFromViconTimeCode( GetTimeCodeResult, FrameData.MetaData.SceneTime );
+    FrameData.MetaData.SceneTime = i_rContext.SceneTime;
   }
-  GetMarkersForSubject(InName, MarkerNames, FrameData.PropertyValues);
+  GetMarkersForSubject(i_rContext, i_rSubject, FrameData.PropertyValues);
 
   return true;
 }
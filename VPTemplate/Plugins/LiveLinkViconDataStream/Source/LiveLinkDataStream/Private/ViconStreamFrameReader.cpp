@@ -8,9 +8,11 @@
 #include "Roles/LiveLinkTransformTypes.h"
 #include "Roles/LiveLinkBasicRole.h"
 #include "Roles/LiveLinkBasicTypes.h"
+#include "LiveLinkViconPointCloudRole.h"
 #include "ILiveLinkDataStreamModule.h"
 
 #include "Async/Async.h"
+#include "Async/ParallelFor.h"
 
 #include "LiveLinkLensRole.h"
 #include "LiveLinkLensTypes.h"
@@ -20,11 +22,114 @@
 #include "LiveLinkSubjectSettings.h"
 #include "LiveLinkFrameInterpolationProcessor.h"
 #include "InterpolationProcessor/LiveLinkBasicFrameInterpolateProcessor.h"
+#include "HAL/Event.h"
+#include "HAL/PlatformAffinity.h"
+#include "Misc/ScopeLock.h"
+
+DECLARE_FLOAT_COUNTER_STAT( TEXT( "Wake To Push (ms)" ), STAT_ViconWakeToPushMs, STATGROUP_ViconDataStream );
+DECLARE_FLOAT_COUNTER_STAT( TEXT( "Max Wake To Push (ms)" ), STAT_ViconMaxWakeToPushMs, STATGROUP_ViconDataStream );
+DECLARE_DWORD_ACCUMULATOR_STAT( TEXT( "Frame Wait Timeouts" ), STAT_ViconFrameWaitTimeouts, STATGROUP_ViconDataStream );
+DECLARE_DWORD_ACCUMULATOR_STAT( TEXT( "Frames Dropped (Ring Full)" ), STAT_ViconFramesDropped, STATGROUP_ViconDataStream );
+DECLARE_DWORD_COUNTER_STAT( TEXT( "Frame Ring Depth" ), STAT_ViconFrameRingDepth, STATGROUP_ViconDataStream );
+DECLARE_DWORD_ACCUMULATOR_STAT( TEXT( "Frames Coalesced" ), STAT_ViconFramesCoalesced, STATGROUP_ViconDataStream );
+DECLARE_FLOAT_COUNTER_STAT( TEXT( "Frame Age At Conversion (ms)" ), STAT_ViconFrameAgeMs, STATGROUP_ViconDataStream );
+DECLARE_DWORD_ACCUMULATOR_STAT( TEXT( "Frame Gaps" ), STAT_ViconFrameGaps, STATGROUP_ViconDataStream );
+DECLARE_DWORD_ACCUMULATOR_STAT( TEXT( "Frames Missed" ), STAT_ViconFramesMissed, STATGROUP_ViconDataStream );
+DECLARE_DWORD_ACCUMULATOR_STAT( TEXT( "Hardware Frame Gaps" ), STAT_ViconHardwareFrameGaps, STATGROUP_ViconDataStream );
+DECLARE_DWORD_ACCUMULATOR_STAT( TEXT( "Duplicate Frames" ), STAT_ViconDuplicateFrames, STATGROUP_ViconDataStream );
+DECLARE_DWORD_ACCUMULATOR_STAT( TEXT( "Reordered Frames" ), STAT_ViconReorderedFrames, STATGROUP_ViconDataStream );
+DECLARE_FLOAT_COUNTER_STAT( TEXT( "Arrival Jitter p50 (ms)" ), STAT_ViconArrivalJitterP50Ms, STATGROUP_ViconDataStream );
+DECLARE_FLOAT_COUNTER_STAT( TEXT( "Arrival Jitter p99 (ms)" ), STAT_ViconArrivalJitterP99Ms, STATGROUP_ViconDataStream );
+DECLARE_FLOAT_COUNTER_STAT( TEXT( "Arrival Jitter Max (ms)" ), STAT_ViconArrivalJitterMaxMs, STATGROUP_ViconDataStream );
+DECLARE_DWORD_ACCUMULATOR_STAT( TEXT( "Schema Revalidations" ), STAT_ViconSchemaRevalidations, STATGROUP_ViconDataStream );
+DECLARE_DWORD_ACCUMULATOR_STAT( TEXT( "Schema Audits" ), STAT_ViconSchemaAudits, STATGROUP_ViconDataStream );
+DECLARE_DWORD_ACCUMULATOR_STAT( TEXT( "Schema Changes" ), STAT_ViconSchemaChanges, STATGROUP_ViconDataStream );
+DECLARE_DWORD_COUNTER_STAT( TEXT( "Unlabeled Marker Capacity" ), STAT_ViconUnlabeledMarkerCapacity, STATGROUP_ViconDataStream );
+DECLARE_DWORD_ACCUMULATOR_STAT( TEXT( "Marker Capacity Resizes" ), STAT_ViconMarkerCapacityResizes, STATGROUP_ViconDataStream );
+DECLARE_CYCLE_STAT( TEXT( "Marker Index Build" ), STAT_ViconMarkerIndexBuild, STATGROUP_ViconDataStream );
+
+namespace
+{
+  // Number of raw frames the conversion thread may fall behind the acquisition thread
+  const uint32 s_FrameRingCapacity = 8;
+  // Delay between attempts to reconnect, doubling after each failure
+  const double s_ReconnectMinDelaySeconds = 0.5;
+  const double s_ReconnectMaxDelaySeconds = 8.0;
+  // Longest a single connection attempt may block the acquisition thread
+  const unsigned int s_ConnectionTimeoutMs = 2000;
+  // Time the reader is given to stop on its own when shutting down, before its blocking GetFrame is released by
+  // disconnecting: at least this long, and at least this many frames of the server
+  const uint32 s_ShutdownGraceMs = 100;
+  const uint32 s_ShutdownGraceFrames = 3;
+  // Number of frames between updates of the arrival jitter percentile stats
+  const uint64 s_JitterStatInterval = 100;
+  // Interval between full comparisons of a cached subject schema whose fingerprint has not changed
+  const double s_SchemaAuditIntervalSeconds = 5.0;
+  // Audits are spread over this many slots of the interval, so they don't all land on the same frame
+  const int32 s_SchemaAuditSlots = 16;
+  // Subjects missing from the stream for this long are dropped from the cache
+  const double s_SubjectExpirySeconds = 10.0;
+  const double s_SubjectPruneIntervalSeconds = 1.0;
+  // Shortest interval between writes of the schema cache while subjects are being added
+  const double s_SchemaCacheSaveIntervalSeconds = 5.0;
+  // A marker subject's capacity shrinks once its count has stayed at or below this fraction of it for the delay,
+  // to the largest count seen meanwhile plus headroom. Resizes are at least the interval apart, except to grow.
+  const double s_MarkerShrinkThreshold = 0.5;
+  const double s_MarkerShrinkDelaySeconds = 5.0;
+  const double s_MarkerShrinkHeadroom = 0.25;
+  const double s_MarkerResizeMinIntervalSeconds = 10.0;
+  // Interval between updates of the gauge stats by each reader
+  const double s_GaugeStatIntervalSeconds = 0.1;
+
+  // Stats of every live reader, so the gauges of the shared stat group can be aggregated across them
+  FCriticalSection s_StatReadersMutex;
+  TArray< const FViconStreamReaderStats* > s_StatReaders;
+
+  // Publish the gauges of all readers: latencies, ages and jitter as the worst reader's, depths and
+  // capacities as the sum over the readers
+  void PublishGaugeStats()
+  {
+#if STATS
+    double WakeToPushMs = 0.0;
+    double MaxWakeToPushMs = 0.0;
+    double FrameAgeMs = 0.0;
+    double JitterP50Ms = 0.0;
+    double JitterP99Ms = 0.0;
+    double JitterMaxMs = 0.0;
+    int32 FrameRingDepth = 0;
+    int32 UnlabeledMarkerCapacity = 0;
+    {
+      FScopeLock Lock( &s_StatReadersMutex );
+      for( const FViconStreamReaderStats* pStats : s_StatReaders )
+      {
+        WakeToPushMs = FMath::Max< double >( WakeToPushMs, pStats->LastWakeToPushMs );
+        MaxWakeToPushMs = FMath::Max< double >( MaxWakeToPushMs, pStats->MaxWakeToPushMs );
+        FrameAgeMs = FMath::Max< double >( FrameAgeMs, pStats->LastFrameAgeMs );
+        JitterP50Ms = FMath::Max< double >( JitterP50Ms, pStats->ArrivalJitterP50Ms );
+        JitterP99Ms = FMath::Max< double >( JitterP99Ms, pStats->ArrivalJitterP99Ms );
+        JitterMaxMs = FMath::Max( JitterMaxMs, pStats->ArrivalJitter.GetMaxMs() );
+        FrameRingDepth += pStats->FrameRingDepth;
+        UnlabeledMarkerCapacity += pStats->UnlabeledMarkerCapacity;
+      }
+    }
+    SET_FLOAT_STAT( STAT_ViconWakeToPushMs, WakeToPushMs );
+    SET_FLOAT_STAT( STAT_ViconMaxWakeToPushMs, MaxWakeToPushMs );
+    SET_FLOAT_STAT( STAT_ViconFrameAgeMs, FrameAgeMs );
+    SET_FLOAT_STAT( STAT_ViconArrivalJitterP50Ms, JitterP50Ms );
+    SET_FLOAT_STAT( STAT_ViconArrivalJitterP99Ms, JitterP99Ms );
+    SET_FLOAT_STAT( STAT_ViconArrivalJitterMaxMs, JitterMaxMs );
+    SET_DWORD_STAT( STAT_ViconFrameRingDepth, FrameRingDepth );
+    SET_DWORD_STAT( STAT_ViconUnlabeledMarkerCapacity, UnlabeledMarkerCapacity );
+#endif
+  }
+}
 
 const std::string FViconStreamFrameReader::UNLABELED_MARKER = "UnlabeledMarker";
 const std::string FViconStreamFrameReader::LABELED_MARKER = "LabeledMarker";
 const std::string FViconStreamFrameReader::MARKER_COUNT_PROPERTY = "MarkerCount";
 
+const uint32 ViconStreamProperties::MIN_PROBE_TIMEOUT_MS = 50;
+
 ViconStreamProperties ViconStreamProperties::FromString( const FString& i_rPropsString )
 {
   ViconStreamProperties Props;
@@ -43,6 +148,14 @@ ViconStreamProperties ViconStreamProperties::FromString( const FString& i_rProps
   }
   Props.m_SubjectFilter = FText::FromString( SubjectFilter );
 
+  FString SubjectPrefix;
+  FParse::Value( *i_rPropsString, TEXT( "SubjectPrefix=" ), SubjectPrefix );
+  Props.m_SubjectPrefix = FText::FromString( SubjectPrefix );
+
+  FString AdditionalSystems;
+  FParse::Value( *i_rPropsString, TEXT( "AdditionalSystems=" ), AdditionalSystems );
+  Props.m_AdditionalSystems = FText::FromString( AdditionalSystems );
+
   FString portnumber;
   if( !FParse::Value( *i_rPropsString, TEXT( "PortNumber=" ), portnumber ) )
   {
@@ -95,6 +208,19 @@ ViconStreamProperties ViconStreamProperties::FromString( const FString& i_rProps
     Props.m_bScaled = true;
   }
 
+  FString ParallelConnect;
+  if( FParse::Value( *i_rPropsString, TEXT( "ParallelConnect=" ), ParallelConnect ) )
+  {
+    Props.m_bParallelConnect = ParallelConnect == "True";
+  }
+  else
+  {
+    Props.m_bParallelConnect = false;
+  }
+
+  FParse::Value( *i_rPropsString, TEXT( "ProbeTimeoutMs=" ), Props.m_ProbeTimeoutMs );
+  Props.m_ProbeTimeoutMs = FMath::Max( Props.m_ProbeTimeoutMs, MIN_PROBE_TIMEOUT_MS );
+
   return Props;
 }
 
@@ -102,24 +228,101 @@ const FString ViconStreamProperties::ToString() const
 {
   FString PropertiesString = FString::Printf( TEXT( "ServerName=\"%s\"" ), *m_ServerName.ToString() );
   PropertiesString.Append( FString::Printf( TEXT( "SubjectFilter=\"%s\"" ), *m_SubjectFilter.ToString() ) );
+  PropertiesString.Append( FString::Printf( TEXT( "SubjectPrefix=\"%s\"" ), *m_SubjectPrefix.ToString() ) );
+  PropertiesString.Append( FString::Printf( TEXT( "AdditionalSystems=\"%s\"" ), *m_AdditionalSystems.ToString() ) );
   PropertiesString.Append( FString::Printf( TEXT( "PortNumber=\"%d\"" ), m_PortNumber ) );
   PropertiesString.Append( FString::Printf( TEXT( "Retimed=\"%s\"" ), m_bRetimed ? TEXT( "True" ) : TEXT( "False" ) ) );
   PropertiesString.Append( FString::Printf( TEXT( "RetimeOffset=\"%d\"" ), m_RetimeOffset ) );
   PropertiesString.Append( FString::Printf( TEXT( "LogOutput=\"%s\"" ), m_bLogOutput ? TEXT( "True" ) : TEXT( "False" ) ) );
   PropertiesString.Append( FString::Printf( TEXT( "UsePrefetch=\"%s\"" ), m_bUsePrefetch ? TEXT( "True" ) : TEXT( "False" ) ) );
   PropertiesString.Append( FString::Printf( TEXT( "Scaled=\"%s\"" ), m_bScaled ? TEXT( "True" ) : TEXT( "False" ) ) );
+  PropertiesString.Append( FString::Printf( TEXT( "ParallelConnect=\"%s\"" ), m_bParallelConnect ? TEXT( "True" ) : TEXT( "False" ) ) );
+  PropertiesString.Append( FString::Printf( TEXT( "ProbeTimeoutMs=\"%u\"" ), m_ProbeTimeoutMs ) );
 
   return PropertiesString;
 }
 
+TArray< ViconStreamProperties > ViconStreamProperties::GetSystems() const
+{
+  // The additional systems are copies of the primary, so build it outside the array it is copied into
+  ViconStreamProperties Primary = *this;
+  Primary.m_AdditionalSystems = FText::GetEmpty();
+  TArray< ViconStreamProperties > Systems;
+  Systems.Add( Primary );
+
+  TArray< FString > Entries;
+  m_AdditionalSystems.ToString().ParseIntoArray( Entries, TEXT( "," ), true );
+  for( const FString& rEntry : Entries )
+  {
+    FString Prefix;
+    FString Server = rEntry;
+    rEntry.Split( TEXT( "=" ), &Prefix, &Server );
+    Server.TrimStartAndEndInline();
+    if( Server.IsEmpty() )
+    {
+      UE_LOG( LogViconStream, Warning, TEXT( "Ignoring additional system \"%s\" with no server name" ), *rEntry );
+      continue;
+    }
+
+    ViconStreamProperties& rSystem = Systems.Add_GetRef( Primary );
+    rSystem.m_ServerName = FText::FromString( Server );
+    rSystem.m_SubjectPrefix = FText::FromString( Prefix.TrimStartAndEnd() );
+  }
+
+  // Subjects from different systems would overwrite each other in LiveLink if they shared a prefix
+  TSet< FString > Prefixes;
+  for( const ViconStreamProperties& rSystem : Systems )
+  {
+    bool bAlreadyUsed = false;
+    Prefixes.Add( rSystem.m_SubjectPrefix.ToString(), &bAlreadyUsed );
+    if( bAlreadyUsed && Systems.Num() > 1 )
+    {
+      UE_LOG( LogViconStream, Warning, TEXT( "Subject prefix \"%s\" is used by more than one system, subjects with the same name will collide" ),
+              *rSystem.m_SubjectPrefix.ToString() );
+    }
+  }
+
+  return Systems;
+}
+
 FViconStreamFrameReader::FViconStreamFrameReader( ILiveLinkClient* i_pClient, const ViconStreamProperties& i_rViconStreamProps, const FGuid& i_rSourceGuid )
 : m_pLiveLinkClient( i_pClient )
 , m_ViconStreamProps( i_rViconStreamProps )
+, m_SubjectPrefix( i_rViconStreamProps.m_SubjectPrefix.ToString().TrimStartAndEnd() )
 , m_SourceGuid( i_rSourceGuid )
-, m_LastFrameNumber( -1 )
 , m_bStopTask( false )
 , m_pThread( nullptr )
+, m_ConversionRunnable( *this )
+, m_pConversionThread( nullptr )
+, m_FrameRing( s_FrameRingCapacity )
+, m_pFrameReadyEvent( FPlatformProcess::GetSynchEventFromPool( false ) )
+, m_bLatestFrameOnly( false )
+, m_SubjectConversionWorkers( 0 )
+, m_bComponentSpacePoses( false )
+, m_bComponentSpacePosesApplied( false )
+, m_bEventDrivenWait( false )
+, m_FrameWaitTimeoutMs( 10 )
+, m_bEventDrivenWaitApplied( false )
+, m_bServerPushWait( false )
+, m_bReconnecting( false )
+, m_bConnecting( false )
+, m_pFrameWaitEvent( FPlatformProcess::GetSynchEventFromPool( false ) )
+, m_pRunFinishedEvent( FPlatformProcess::GetSynchEventFromPool( true ) )
+, m_Names( m_SubjectPrefix )
+, m_bTrackUnlabeledMarkers( false )
+, m_UnlabeledMarkerGateDistance( 5.0f )
+, m_bPublishMarkerIndex( false )
+, m_LabeledMarkerName( *( m_SubjectPrefix + LABELED_MARKER.c_str() ) )
+, m_UnlabeledMarkerName( *( m_SubjectPrefix + UNLABELED_MARKER.c_str() ) )
+, m_NextSubjectPruneSeconds( 0.0 )
+, m_bSchemaCacheDirty( false )
+, m_bWarmStartPending( false )
+, m_NextSchemaCacheSaveSeconds( 0.0 )
 {
+  {
+    FScopeLock Lock( &s_StatReadersMutex );
+    s_StatReaders.Add( &m_Stats );
+  }
   Connect();
 }
 
@@ -140,12 +343,46 @@ void FViconStreamFrameReader::DisablePropertyInterpolation(FLiveLinkSubjectKey S
 FViconStreamFrameReader::~FViconStreamFrameReader()
 {
   Shutdown();
+  {
+    FScopeLock Lock( &s_StatReadersMutex );
+    s_StatReaders.Remove( &m_Stats );
+  }
+
+  // The conversion thread never blocks in the SDK, so it stops as soon as it wakes up
+  if( m_pConversionThread )
+  {
+    m_pConversionThread->WaitForCompletion();
+    delete m_pConversionThread;
+    m_pConversionThread = nullptr;
+  }
 
   {
+    // The stream is in ServerPush unless prefetching, whether or not the wait is event driven, so GetFrame
+    // blocks inside the SDK until the server sends a frame. If the server has gone quiet, disconnecting is the
+    // only way to release it, so give the reader a few frames to notice the stop request first. The reader
+    // holds the connection mutex while it captures a frame, so this can't disconnect in the middle of one.
+    const double FrameRateHz = m_Stats.ServerFrameRateHz;
+    const uint32 FramePeriodMs = FrameRateHz > 0.0 ? static_cast< uint32 >( FMath::CeilToDouble( 1000.0 / FrameRateHz ) ) : 0;
+    const uint32 GraceMs = FMath::Max( s_ShutdownGraceMs, s_ShutdownGraceFrames * FramePeriodMs );
+    // A connect in flight holds the mutex until it times out, but the reader checks for the stop request as soon
+    // as it returns, so leave it be rather than wait for it here.
+    if( !m_pRunFinishedEvent->Wait( GraceMs ) && !m_bConnecting )
+    {
+      UE_LOG( LogViconStream, Log, TEXT( "Reader did not stop within %u ms, disconnecting to release it" ), GraceMs );
+      FScopeLock Lock( &m_ConnectionMutex );
+      m_DataStream.Disconnect();
+    }
     m_pThread->WaitForCompletion();
     delete m_pThread;
     m_pThread = nullptr;
   }
+
+  FPlatformProcess::ReturnSynchEventToPool( m_pFrameReadyEvent );
+  m_pFrameReadyEvent = nullptr;
+  FPlatformProcess::ReturnSynchEventToPool( m_pFrameWaitEvent );
+  m_pFrameWaitEvent = nullptr;
+  FPlatformProcess::ReturnSynchEventToPool( m_pRunFinishedEvent );
+  m_pRunFinishedEvent = nullptr;
 }
 
 bool FViconStreamFrameReader::Init()
@@ -155,62 +392,371 @@ bool FViconStreamFrameReader::Init()
 
 uint32 FViconStreamFrameReader::Run()
 {
-  ConnectInternal();
-
-  // If we don't connect, quit the thread immediately
-  if( !m_DataStream.IsConnected() )
-  {
-    return 0;
-  }
-
   // We only use properties to send marker data, which cannot be interpolated.
   FDelegateHandle SubjectAddedDelegateHandle = m_pLiveLinkClient->OnLiveLinkSubjectAdded()
     .AddRaw(this, &FViconStreamFrameReader::DisablePropertyInterpolation);
 
+  WarmStartFromSchemaCache();
+
+  int32 SchedulingVersion = -1;
+  bool bEverConnected = false;
+  double ReconnectDelaySeconds = s_ReconnectMinDelaySeconds;
   while( !m_bStopTask )
   {
+    UpdateScheduling( true, SchedulingVersion );
+
+    // Keep trying to (re)connect, backing off exponentially. Stop() wakes the wait so shutdown is not held up.
+    if( !m_DataStream.IsConnected() )
+    {
+      if( bEverConnected )
+      {
+        if( !m_bReconnecting )
+        {
+          OnConnectionLost();
+        }
+        ++m_Stats.ReconnectAttempts;
+      }
+
+      ConnectInternal();
+      if( m_DataStream.IsConnected() )
+      {
+        if( m_bReconnecting )
+        {
+          OnConnectionRestored();
+        }
+        bEverConnected = true;
+        ReconnectDelaySeconds = s_ReconnectMinDelaySeconds;
+        continue;
+      }
+
+      UE_LOG( LogViconStream, Display, TEXT( "Retrying connection in %.1f s" ), ReconnectDelaySeconds );
+      m_pFrameWaitEvent->Wait( FTimespan::FromSeconds( ReconnectDelaySeconds ) );
+      ReconnectDelaySeconds = FMath::Min( ReconnectDelaySeconds * 2.0, s_ReconnectMaxDelaySeconds );
+      continue;
+    }
+
+    UpdateFrameWaitMode();
+
     EResult r = m_DataStream.GetFrame();
     if( r != ESuccess )
     {
-      FPlatformProcess::Sleep( 0.001f );
+      WaitForNextFrame();
       continue;
     }
+    // Held until the frame has been captured, so that a forced disconnect on shutdown waits for it
+    FScopeLock CaptureLock( &m_ConnectionMutex );
+    const uint64 WakeCycles = FPlatformTime::Cycles64();
 
-    auto ViconFrameNumber = m_DataStream.GetFrameNumber();
+    FViconFrameContext Context;
+    Context.FrameNumber = m_DataStream.GetFrameNumber();
+    Context.HardwareFrameNumber = m_DataStream.GetHardwareFrameNumber();
 
     bool bRetimed = m_DataStream.IsRetimed();
-    if( bRetimed )
+    // no new frame. In ServerPush the next GetFrame blocks until there is one, so go straight back to it.
+    if( !bRetimed && !TrackFrameSequence( Context ) )
     {
-      HandleSubjectData();
+      if( !m_bServerPushWait )
+      {
+        CaptureLock.Unlock();
+        FPlatformProcess::Sleep( 0.001f );
+      }
       continue;
     }
-    // no new frame
-    if( ViconFrameNumber == m_LastFrameNumber )
+    RecordArrival( WakeCycles );
+
+    // Drop the whole frame if the conversion thread is a full ring behind. Nothing has been read from the
+    // SDK or cached for it yet, so any subjects or cameras it would have added are picked up by the next frame.
+    FViconRawFrame* pFrame = m_FrameRing.BeginWrite();
+    if( !pFrame )
     {
-      FPlatformProcess::Sleep( 0.001f );
+      ++m_Stats.FramesDropped;
+      INC_DWORD_STAT( STAT_ViconFramesDropped );
       continue;
     }
-    else
+
+    pFrame->Reset();
+    pFrame->WakeCycles = WakeCycles;
+    // Everything in the frame shares these, so read them from the SDK once rather than per subject, camera or marker
+    m_DataStream.CaptureFrameContext( Context );
+    pFrame->Context = Context;
+    HandleSubjectData( *pFrame );
+    if( !bRetimed )
+    {
+      HandleCameraData( *pFrame );
+      HandleMarkerData( *pFrame );
+    }
+    m_FrameRing.CommitWrite();
+    m_pFrameReadyEvent->Trigger();
+
+    ++m_Stats.FramesAcquired;
+    m_Stats.FrameRingDepth = static_cast< int32 >( m_FrameRing.Num() );
+
+    if( m_bSchemaCacheDirty && FPlatformTime::Seconds() >= m_NextSchemaCacheSaveSeconds )
     {
-      m_LastFrameNumber = ViconFrameNumber;
-      HandleSubjectData();
-      HandleCameraData();
-      HandleMarkerData();
+      SaveSchemaCache( false );
     }
   }
 
+  SaveSchemaCache( true );
   m_CachedSubjects.Empty();
   m_CachedCameras.Empty();
-  m_CachedMarkers.Empty();
-  m_DataStream.Disconnect();
+  m_Names.Empty();
+  m_SkeletonTemplates.Empty();
+  {
+    FScopeLock Lock( &m_ConnectionMutex );
+    m_DataStream.Disconnect();
+  }
   m_pLiveLinkClient->OnLiveLinkSubjectAdded().Remove(SubjectAddedDelegateHandle);
+  m_pRunFinishedEvent->Trigger();
   
   return 0;
 }
 
+uint32 FViconStreamFrameReader::FConversionRunnable::Run()
+{
+  return m_rReader.RunConversion();
+}
+
+uint32 FViconStreamFrameReader::RunConversion()
+{
+  int32 SchedulingVersion = -1;
+  while( !m_bStopTask )
+  {
+    UpdateScheduling( false, SchedulingVersion );
+
+    while( FViconRawFrame* pFrame = m_bLatestFrameOnly ? CoalesceFrames() : m_FrameRing.BeginRead() )
+    {
+      if( m_bStopTask )
+      {
+        break;
+      }
+      ConvertFrame( *pFrame );
+      m_FrameRing.EndRead();
+    }
+
+    // The event is auto-reset, so a frame committed since the ring was found empty is not missed
+    m_pFrameReadyEvent->Wait( m_FrameWaitTimeoutMs.GetValue() );
+  }
+
+  m_CachedMarkers.Empty();
+  m_UnlabeledMarkerTracker.Reset();
+  WithdrawMarkerIndex();
+
+  return 0;
+}
+
+FViconRawFrame* FViconStreamFrameReader::CoalesceFrames()
+{
+  FViconRawFrame* pFrame = m_FrameRing.BeginRead();
+  // Only frames published before we started are considered, so this can't chase a producer which keeps up
+  for( uint32 Superseded = pFrame ? m_FrameRing.Num() - 1 : 0; Superseded > 0 && !m_bStopTask; --Superseded )
+  {
+    // Subject removals and static data must still reach LiveLink in order, only the frame data is skipped
+    ApplyFrameEvents( *pFrame );
+    m_FrameRing.EndRead();
+    pFrame = m_FrameRing.BeginRead();
+
+    ++m_Stats.FramesCoalesced;
+    INC_DWORD_STAT( STAT_ViconFramesCoalesced );
+  }
+  return pFrame;
+}
+
+void FViconStreamFrameReader::ApplyFrameEvents( FViconRawFrame& io_rFrame )
+{
+  for( const FName& rSubjectName : io_rFrame.RemovedSubjects )
+  {
+    if( !m_bStopTask )
+    {
+      m_pLiveLinkClient->RemoveSubject_AnyThread( {m_SourceGuid, rSubjectName} );
+    }
+  }
+
+  for( FViconStaticDataUpdate& rUpdate : io_rFrame.StaticDataUpdates )
+  {
+    if( !m_bStopTask )
+    {
+      m_pLiveLinkClient->PushSubjectStaticData_AnyThread( {m_SourceGuid, rUpdate.SubjectName}, rUpdate.Role, MoveTemp( rUpdate.StaticData ) );
+    }
+  }
+  io_rFrame.StaticDataUpdates.Reset();
+  io_rFrame.RemovedSubjects.Reset();
+}
+
+void FViconStreamFrameReader::ConvertFrame( FViconRawFrame& io_rFrame )
+{
+  m_Stats.RecordFrameAge( io_rFrame.WakeCycles );
+  const double NowSeconds = FPlatformTime::Seconds();
+  if( NowSeconds >= m_NextGaugeStatSeconds )
+  {
+    m_NextGaugeStatSeconds = NowSeconds + s_GaugeStatIntervalSeconds;
+    PublishGaugeStats();
+  }
+
+  ApplyFrameEvents( io_rFrame );
+
+  PushSubjectData( io_rFrame );
+  if( io_rFrame.bHasCameraData )
+  {
+    PushCameraData( io_rFrame );
+  }
+  if( io_rFrame.bHasMarkerData )
+  {
+    FViconMarkerIndex* pMarkerIndex = BeginMarkerIndex( io_rFrame.Context );
+    PushMarkerData( true, io_rFrame.Context, io_rFrame.LabeledMarkers, pMarkerIndex );
+    PushMarkerData( false, io_rFrame.Context, io_rFrame.UnlabeledMarkers, pMarkerIndex );
+    if( pMarkerIndex )
+    {
+      PublishMarkerIndex();
+    }
+  }
+
+  RecordFrameContext( io_rFrame.Context );
+  RecordWakeToPush( io_rFrame.WakeCycles );
+}
+
 void FViconStreamFrameReader::Stop()
 {
   m_bStopTask = true;
+  m_pFrameWaitEvent->Trigger();
+  m_pFrameReadyEvent->Trigger();
+}
+
+void FViconStreamFrameReader::UpdateFrameWaitMode()
+{
+  const bool bEventDriven = m_bEventDrivenWait;
+  if( bEventDriven == m_bEventDrivenWaitApplied )
+  {
+    return;
+  }
+  m_bEventDrivenWaitApplied = bEventDriven;
+
+  // The retiming client always waits on its own clock
+  if( m_DataStream.IsRetimed() )
+  {
+    return;
+  }
+
+  if( bEventDriven )
+  {
+    // In ServerPush, GetFrame blocks until a frame we have not processed yet arrives, so there is no need to poll
+    m_bServerPushWait = m_DataStream.SetStreamMode( EPush ) == ESuccess;
+    if( m_bServerPushWait )
+    {
+      UE_LOG( LogViconStream, Display, TEXT( "Using event driven frame wait" ) );
+    }
+    else
+    {
+      UE_LOG( LogViconStream, Warning, TEXT( "Failed to set streaming mode to Push; falling back to polling for frames" ) );
+    }
+  }
+  else
+  {
+    m_bServerPushWait = false;
+    m_DataStream.SetStreamMode( m_ViconStreamProps.m_bUsePrefetch ? EPullPreFetch : EPush );
+    UE_LOG( LogViconStream, Display, TEXT( "Using polled frame wait" ) );
+  }
+}
+
+void FViconStreamFrameReader::WaitForNextFrame()
+{
+  if( !m_bServerPushWait )
+  {
+    FPlatformProcess::Sleep( 0.001f );
+    return;
+  }
+
+  // GetFrame only returns early in ServerPush when there is nothing to wait on (e.g. the connection dropped),
+  // so wait for a stop request, bounded by the timeout.
+  if( !m_pFrameWaitEvent->Wait( m_FrameWaitTimeoutMs.GetValue() ) )
+  {
+    ++m_Stats.FrameWaitTimeouts;
+    INC_DWORD_STAT( STAT_ViconFrameWaitTimeouts );
+  }
+}
+
+void FViconStreamFrameReader::RecordWakeToPush( uint64 i_WakeCycles )
+{
+  m_Stats.RecordWakeToPush( i_WakeCycles );
+}
+
+void FViconStreamFrameReader::RecordFrameContext( const FViconFrameContext& i_rContext )
+{
+  m_Stats.LastSceneTimeSeconds = i_rContext.bHasTimecode ? i_rContext.SceneTime.AsSeconds() : -1.0;
+  m_Stats.ServerFrameRateHz = i_rContext.FrameRateHz;
+}
+
+bool FViconStreamFrameReader::TrackFrameSequence( const FViconFrameContext& i_rContext )
+{
+  // When polling, GetFrame returns the same frame until the next one arrives, so only count repeats in ServerPush
+  const bool bNewFrame = m_FrameSequence.AddFrame( i_rContext.FrameNumber, i_rContext.HardwareFrameNumber, m_bServerPushWait );
+
+  const FViconFrameSequenceCounts Counts = m_FrameSequence.GetTotalCounts();
+  INC_DWORD_STAT_BY( STAT_ViconFrameGaps, Counts.Gaps - m_PublishedSequenceCounts.Gaps );
+  INC_DWORD_STAT_BY( STAT_ViconFramesMissed, Counts.FramesMissed - m_PublishedSequenceCounts.FramesMissed );
+  INC_DWORD_STAT_BY( STAT_ViconHardwareFrameGaps, Counts.HardwareGaps - m_PublishedSequenceCounts.HardwareGaps );
+  INC_DWORD_STAT_BY( STAT_ViconDuplicateFrames, Counts.Duplicates - m_PublishedSequenceCounts.Duplicates );
+  INC_DWORD_STAT_BY( STAT_ViconReorderedFrames, Counts.Reorders - m_PublishedSequenceCounts.Reorders );
+  m_PublishedSequenceCounts = Counts;
+
+  return bNewFrame;
+}
+
+void FViconStreamFrameReader::RecordArrival( uint64 i_WakeCycles )
+{
+  m_Stats.RecordArrival( i_WakeCycles );
+
+  const FViconJitterHistogram& rJitter = m_Stats.ArrivalJitter;
+  if( rJitter.Num() % s_JitterStatInterval == 0 )
+  {
+    m_Stats.ArrivalJitterP50Ms = rJitter.GetPercentileMs( 50.0 );
+    m_Stats.ArrivalJitterP99Ms = rJitter.GetPercentileMs( 99.0 );
+  }
+}
+
+void FViconStreamFrameReader::UpdateScheduling( bool i_bAcquisitionThread, int32& io_rAppliedVersion )
+{
+  const int32 Version = m_SchedulingVersion.GetValue();
+  if( Version == io_rAppliedVersion )
+  {
+    return;
+  }
+  io_rAppliedVersion = Version;
+
+  FSchedulingProfile Profile;
+  {
+    FScopeLock Lock( &m_SchedulingMutex );
+    Profile = m_SchedulingProfile;
+  }
+
+  if( FRunnableThread* pThread = FRunnableThread::GetRunnableThread() )
+  {
+    pThread->SetThreadPriority( Profile.Priority );
+  }
+
+  const int32 NumCores = FMath::Min( FPlatformMisc::NumberOfCoresIncludingHyperthreads(), 64 );
+  const uint64 AllCores = NumCores >= 64 ? ~uint64( 0 ) : ( uint64( 1 ) << NumCores ) - 1;
+  uint64 AffinityMask = Profile.AffinityMask & AllCores;
+  if( Profile.DedicatedCore >= 0 && Profile.DedicatedCore < NumCores )
+  {
+    const uint64 DedicatedCoreMask = uint64( 1 ) << Profile.DedicatedCore;
+    // The acquisition thread gets the core to itself, as far as this source is concerned
+    AffinityMask = i_bAcquisitionThread ? DedicatedCoreMask : ( AffinityMask != 0 ? AffinityMask : AllCores ) & ~DedicatedCoreMask;
+  }
+  else if( Profile.DedicatedCore >= 0 )
+  {
+    UE_LOG( LogViconStream, Warning, TEXT( "Dedicated core %d is out of range, this machine has %d logical cores" ), Profile.DedicatedCore, NumCores );
+  }
+  FPlatformProcess::SetThreadAffinityMask( AffinityMask != 0 ? AffinityMask : FPlatformAffinity::GetNoAffinityMask() );
+
+  UE_LOG( LogViconStream, Display, TEXT( "%s thread priority %d, affinity 0x%llx" ),
+          i_bAcquisitionThread ? TEXT( "Acquisition" ) : TEXT( "Conversion" ), static_cast< int32 >( Profile.Priority ), AffinityMask );
+
+  // Jitter measured under the previous profile is not comparable
+  if( i_bAcquisitionThread )
+  {
+    m_Stats.ResetArrivalJitter();
+  }
 }
 
 void FViconStreamFrameReader::Shutdown()
@@ -235,13 +781,24 @@ void FViconStreamFrameReader::Connect()
       m_pThread = nullptr;
     }
 
+    if( !m_pConversionThread )
+    {
+      m_pConversionThread = FRunnableThread::Create( &m_ConversionRunnable, TEXT( "FViconStreamFrameConverter" ), 0, TPri_BelowNormal );
+    }
     m_pThread = FRunnableThread::Create( this, TEXT( "FViconStreamFrameReader" ), 0, TPri_BelowNormal );
   }
 }
 
 FString FViconStreamFrameReader::ConstructServerAddress()
 {
-  FString ServerAddress;
+  // Build up the semi-colon separated list of servers and ports e.g
+  // localhost:804;192.168.2.1:804
+  return FString::Join( ConstructServerAddresses(), TEXT( ";" ) );
+}
+
+TArray< FString > FViconStreamFrameReader::ConstructServerAddresses()
+{
+  TArray< FString > ServerAddresses;
 
   FString ServerName = m_ViconStreamProps.m_ServerName.ToString();
   unsigned int ServerPort = m_ViconStreamProps.m_PortNumber;
@@ -252,8 +809,6 @@ FString FViconStreamFrameReader::ConstructServerAddress()
   {
     for( FString Server : Servers )
     {
-      FString ServerAndPort;
-
       // We do not allow spaces in the input argument to the datastream connect. Remove any the
       // user may have added in their input string.
       FString TrimmedServer = Server.TrimStartAndEnd();
@@ -261,25 +816,16 @@ FString FViconStreamFrameReader::ConstructServerAddress()
       // If the server address already contains a port, e.g. localhost:801, don't add the port
       if( TrimmedServer.Contains( TEXT( ":" ) ) )
       {
-        ServerAndPort = TrimmedServer;
+        ServerAddresses.Add( TrimmedServer );
       }
       else
       {
-        ServerAndPort = TrimmedServer + ":" + FString::FromInt( ServerPort );
-      }
-
-      // Build up the semi-colon separated list of servers and ports e.g
-      // localhost:804;192.168.2.1:804
-      if( !ServerAddress.IsEmpty() )
-      {
-        ServerAddress += ";";
+        ServerAddresses.Add( TrimmedServer + ":" + FString::FromInt( ServerPort ) );
       }
-
-      ServerAddress += ServerAndPort;
     }
   }
 
-  return ServerAddress;
+  return ServerAddresses;
 }
 
 void FViconStreamFrameReader::SetLightweightEnabled( bool i_bLightweight )
@@ -298,6 +844,54 @@ void FViconStreamFrameReader::ShowAllVideoCamera( bool i_bShow )
   m_bShowAllVideoCamera = i_bShow;
 }
 
+void FViconStreamFrameReader::SetEventDrivenFrameWait( bool i_bEventDriven, int32 i_TimeoutMs )
+{
+  // Applied on the reader thread, as the stream mode can only be changed once connected
+  m_FrameWaitTimeoutMs.Set( FMath::Max( i_TimeoutMs, 1 ) );
+  m_bEventDrivenWait = i_bEventDriven;
+}
+
+void FViconStreamFrameReader::SetLatestFrameOnly( bool i_bLatestFrameOnly )
+{
+  m_bLatestFrameOnly = i_bLatestFrameOnly;
+}
+
+void FViconStreamFrameReader::SetComponentSpacePoses( bool i_bComponentSpacePoses )
+{
+  m_bComponentSpacePoses = i_bComponentSpacePoses;
+}
+
+void FViconStreamFrameReader::SetUnlabeledMarkerTracking( bool i_bTrack, float i_GateDistance )
+{
+  // Applied on the conversion thread, which owns the tracker
+  m_UnlabeledMarkerGateDistance = FMath::Max( i_GateDistance, 0.1f );
+  m_bTrackUnlabeledMarkers = i_bTrack;
+}
+
+void FViconStreamFrameReader::SetMarkerIndexEnabled( bool i_bEnabled )
+{
+  // Applied on the conversion thread, which withdraws the published index when disabled
+  m_bPublishMarkerIndex = i_bEnabled;
+}
+
+void FViconStreamFrameReader::SetSchedulingProfile( EThreadPriority i_Priority, uint64 i_AffinityMask, int32 i_DedicatedCore )
+{
+  // Applied by each reader thread to itself, as thread affinity can only be set for the calling thread
+  {
+    FScopeLock Lock( &m_SchedulingMutex );
+    m_SchedulingProfile.Priority = i_Priority;
+    m_SchedulingProfile.AffinityMask = i_AffinityMask;
+    m_SchedulingProfile.DedicatedCore = i_DedicatedCore;
+  }
+  m_SchedulingVersion.Increment();
+  m_pFrameReadyEvent->Trigger();
+}
+
+void FViconStreamFrameReader::SetSubjectConversionWorkers( int32 i_NumWorkers )
+{
+  m_SubjectConversionWorkers.Set( FMath::Max( i_NumWorkers, 0 ) );
+}
+
 void FViconStreamFrameReader::SetMarkerEnabled( bool i_bStreamMarker )
 {
   // Intermediate bool for same reason as m_bLightweight
@@ -314,10 +908,51 @@ void FViconStreamFrameReader::SetUnlabeledMarkerEnabled( bool i_bStreamMarker )
 
 void FViconStreamFrameReader::ConnectInternal()
 {
-  FString ServerAddress = ConstructServerAddress();
+  // The SDK tries the servers of a list one after the other, each with the full connection timeout.
+  // Probe them all at once instead and connect to whichever answers first.
+  const TArray< FString > ServerAddresses = ConstructServerAddresses();
+  FString ServerAddress = FString::Join( ServerAddresses, TEXT( ";" ) );
+  unsigned int ConnectionTimeoutMs = s_ConnectionTimeoutMs;
+  if( m_ViconStreamProps.m_bParallelConnect && ServerAddresses.Num() > 1 )
+  {
+    const uint32 ProbeTimeoutMs = FMath::Max( m_ViconStreamProps.m_ProbeTimeoutMs, ViconStreamProperties::MIN_PROBE_TIMEOUT_MS );
+    const int32 ServerIndex = ViconStream::ProbeServers( ServerAddresses, ProbeTimeoutMs, m_bStopTask );
+    if( m_bStopTask )
+    {
+      return;
+    }
+    if( ServerIndex == INDEX_NONE )
+    {
+      UE_LOG( LogViconStream, Display, TEXT( "No server in %s delivered a frame within %u ms" ), *ServerAddress, ProbeTimeoutMs );
+      return;
+    }
+    ServerAddress = ServerAddresses[ ServerIndex ];
+    // The winner has just answered, so connecting to it should take no longer than the probe did. If it went
+    // away in the meantime, fail as quickly as a probe would rather than after the full connection timeout.
+    ConnectionTimeoutMs = ProbeTimeoutMs;
+  }
+
   UE_LOG( LogViconStream, Log, TEXT( "Connecting to datastream on %s" ), *ServerAddress );
 
-  EResult ret = m_DataStream.Connect( ServerAddress, m_ViconStreamProps.m_bRetimed, m_ViconStreamProps.m_bLogOutput );
+  EResult ret = EResult::EError;
+  {
+    FScopeLock Lock( &m_ConnectionMutex );
+    // Checked under the mutex, so once the destructor has asked us to stop no new connect can start
+    if( m_bStopTask )
+    {
+      return;
+    }
+    m_bConnecting = true;
+    m_DataStream.SetConnectionTimeout( ConnectionTimeoutMs );
+    ret = m_DataStream.Connect( ServerAddress, m_ViconStreamProps.m_bRetimed, m_ViconStreamProps.m_bLogOutput );
+    m_bConnecting = false;
+  }
+
+  // The GetFrame below blocks in ServerPush, and nothing would release it if we were asked to stop meanwhile
+  if( m_bStopTask )
+  {
+    return;
+  }
 
   if( ret != ESuccess )
   {
@@ -355,14 +990,7 @@ void FViconStreamFrameReader::ConnectInternal()
     m_DataStream.SetLightWeightEnabled( m_bLightweight );
     m_DataStream.SetMarkerDataEnabled( m_bLabeledMarker );
     m_DataStream.SetUnlabeledMarkerDataEnabled( m_bUnlabeledMarker );
-    if( !m_ViconStreamProps.m_SubjectFilter.IsEmpty() )
-    {
-      m_ViconStreamProps.m_SubjectFilter.ToString().ParseIntoArray( m_SubjectAllowed, TEXT( "," ), true );
-      for( auto& Subject : m_SubjectAllowed )
-      {
-        Subject = Subject.TrimStartAndEnd();
-      }
-    }
+    m_SubjectAllowed = ParseSubjectFilter();
   }
   else
   {
@@ -375,18 +1003,61 @@ bool FViconStreamFrameReader::IsConnected() const
   return m_DataStream.IsConnected();
 }
 
-//Cameras
-void FViconStreamFrameReader::ClearCamerasFromLiveLink( const TSet< FString >& i_rStaleCameras )
+void FViconStreamFrameReader::OnConnectionLost()
 {
-  for( const auto& Camera : i_rStaleCameras )
+  // Leave the subjects and their static data in LiveLink, holding their last frame, so that anything bound
+  // to them carries on once frames flow again. The caches are kept so nothing is re-sent unless it changed.
   {
-    FLiveLinkSubjectKey SubjectKey( m_SourceGuid, FName( *Camera ) );
-    if( !m_bStopTask )
-    {
-      m_pLiveLinkClient->RemoveSubject_AnyThread( SubjectKey );
+    FScopeLock Lock( &m_ConnectionMutex );
+    m_DataStream.Disconnect();
+  }
+  m_bServerPushWait = false;
+  m_bEventDrivenWaitApplied = false;
+
+  m_HeldSubjectCount.Set( m_CachedSubjects.Num() + m_CachedCameras.Num() );
+  m_bReconnecting = true;
+  UE_LOG( LogViconStream, Warning, TEXT( "Lost connection to %s, %d subjects hold their last frame until it is back" ),
+          *ConstructServerAddress(), m_HeldSubjectCount.GetValue() );
+}
+
+void FViconStreamFrameReader::OnConnectionRestored()
+{
+  m_FrameSequence.ResetSequence();
+  m_Stats.RestartArrivals();
+  ++m_Stats.Reconnects;
+
+  UE_LOG( LogViconStream, Display, TEXT( "Reconnected to %s, resuming %d subjects" ),
+          *ConstructServerAddress(), m_HeldSubjectCount.GetValue() );
+  m_HeldSubjectCount.Reset();
+  m_bReconnecting = false;
+}
+
+TSet< FViconNameId > FViconStreamFrameReader::ParseSubjectFilter() const
+{
+  TSet< FViconNameId > SubjectAllowed;
+  if( !m_ViconStreamProps.m_SubjectFilter.IsEmpty() )
+  {
+    TArray< FString > Subjects;
+    m_ViconStreamProps.m_SubjectFilter.ToString().ParseIntoArray( Subjects, TEXT( "," ), true );
+    FViconNamePool& rPool = FViconNamePool::Get();
+    for( const FString& rSubject : Subjects )
+    {
+      SubjectAllowed.Add( rPool.Intern( rSubject.TrimStartAndEnd() ) );
     }
+  }
+  return SubjectAllowed;
+}
+
+//Cameras
+void FViconStreamFrameReader::ClearCamerasFromLiveLink( const TSet< FViconNameId >& i_rStaleCameras, FViconRawFrame& io_rFrame )
+{
+  for( const FViconNameId Camera : i_rStaleCameras )
+  {
+    const FName CameraName = m_Names.FindOrAdd( Camera )->LiveLinkName;
+    io_rFrame.RemovedSubjects.Add( CameraName );
     m_CachedCameras.Remove( Camera );
-    UE_LOG( LogViconStream, Log, TEXT( "Removing camera %s" ), *SubjectKey.SubjectName.ToString() );
+    m_Names.Remove( Camera );
+    UE_LOG( LogViconStream, Log, TEXT( "Removing camera %s" ), *CameraName.ToString() );
   }
 }
 
@@ -396,196 +1067,631 @@ void FViconStreamFrameReader::ClearMarkerFromLiveLink( const FLiveLinkSubjectKey
   {
     m_pLiveLinkClient->RemoveSubject_AnyThread( i_rMarkerKey );
   }
-  if (FCachedMarker* pCachedMarker = m_CachedMarkers.Find(i_rMarkerKey.SubjectName.ToString()))
+  if (FCachedMarker* pCachedMarker = m_CachedMarkers.Find(i_rMarkerKey.SubjectName))
   {
     pCachedMarker->SubjectPresent = false;
   }
-  UE_LOG( LogViconStream, Log, TEXT( "Removing subject %s" ), *i_rMarkerKey.SubjectName.ToString() );
-}
-
-TArray<FName> FViconStreamFrameReader::GetGenericMarkerPropertyNames(unsigned int MarkerCount)
-{
-  // Markers are in the format [n, x1, y1, z1 ... xn, yn, zn, 0, 0, 0 ... , 0, 0, 0]
-  TArray<FName> PropertyNames;
-  PropertyNames.Emplace(MARKER_COUNT_PROPERTY.c_str());
-  for (unsigned int MarkerIndex = 0; MarkerIndex < MarkerCount; ++MarkerIndex)
+  if( i_rMarkerKey.SubjectName == m_UnlabeledMarkerName )
   {
-    PropertyNames.Emplace(FString::FromInt(MarkerIndex) + "_X");
-    PropertyNames.Emplace(FString::FromInt(MarkerIndex) + "_Y");
-    PropertyNames.Emplace(FString::FromInt(MarkerIndex) + "_Z");
+    m_UnlabeledMarkerTracker.Reset();
+    m_Stats.UnlabeledMarkerTracks = 0;
   }
-  return PropertyNames;
+  UE_LOG( LogViconStream, Log, TEXT( "Removing subject %s" ), *i_rMarkerKey.SubjectName.ToString() );
 }
 
-void FViconStreamFrameReader::HandleMarkerData(bool bLabeled)
+void FViconStreamFrameReader::PushMarkerData(bool bLabeled, const FViconFrameContext& i_rContext, const FViconRawMarkerSet& i_rMarkers, FViconMarkerIndex* io_pMarkerIndex)
 {
   if (m_bStopTask)
   {
     return;
   }
 
-  FString SubjectName(bLabeled ? LABELED_MARKER.c_str() : UNLABELED_MARKER.c_str());
-  FLiveLinkSubjectKey SubjectKey( m_SourceGuid, FName( *SubjectName ) );
+  const FName SubjectName = bLabeled ? m_LabeledMarkerName : m_UnlabeledMarkerName;
+  FLiveLinkSubjectKey SubjectKey( m_SourceGuid, SubjectName );
   // We need to remove the marker subject if its streaming option is disabled.
   // We always have the marker subject present if its streaming option is enabled
   // rather than removing it if the marker count drops to zero, as this would cause
   // the subject presence to flicker if it dropped to zero intermittently.
-  bool MarkerEnabled = bLabeled ? m_bLabeledMarker : m_bUnlabeledMarker;
-  if (!MarkerEnabled)
+  if (!i_rMarkers.bEnabled)
   {
     ClearMarkerFromLiveLink(SubjectKey);
     return;
   }
 
-  unsigned int MarkerCount = 0;
-  const auto CountResult = bLabeled ? m_DataStream.GetLabeledMarkerCount(MarkerCount) : m_DataStream.GetUnlabeledMarkerCount(MarkerCount);
-  if (CountResult == EResult::EError)
+  if (!i_rMarkers.bCountValid)
   {
-    UE_LOG(LogViconStream, Warning, TEXT("Failed to get marker count for %s"), *SubjectName);
+    UE_LOG(LogViconStream, Warning, TEXT("Failed to get marker count for %s"), *SubjectName.ToString());
     ClearMarkerFromLiveLink(SubjectKey);
     return;
   }
+  const unsigned int MarkerCount = i_rMarkers.Count;
 
   FCachedMarker& rCachedMarker = m_CachedMarkers.FindOrAdd(SubjectName, FCachedMarker());
   // We want to avoid updating the subject static data very often as frames will be dropped between the data
   // format changing and the static data being updated on Live Link's consumer thread. We therefore keep
-  // a count of the maximum number of unlabeled markers seen on every frame and use that to size the property
-  // dictionary. We write in the markers we have for the frame and a count to the count entry and leave the
+  // a count of the maximum number of unlabeled markers seen on every frame and use that as the capacity
+  // of the point cloud. We write in the markers we have for the frame, mark them valid, and leave the
   // rest zeroed.
-  // If subject is not present, we need to add it.  If marker count is higher than the current max, 
-  // we need to update the maximum and the static data.
-  bool NewMax = MarkerCount > rCachedMarker.MaxCount;
-  if (!rCachedMarker.SubjectPresent || NewMax)
+  // The maximum shrinks again after the count has stayed well below it for a while, so one noisy frame
+  // does not size every later frame. Shrinking is rate limited, so the static data does not thrash.
+  // If subject is not present, we need to add it.  If the capacity changed, we need to update the static data.
+  const bool bResized = UpdateMarkerCapacity( rCachedMarker, MarkerCount, FPlatformTime::Seconds() );
+  if( bLabeled )
+  {
+    m_Stats.LabeledMarkerCapacity = static_cast< int32 >( rCachedMarker.MaxCount );
+  }
+  else
+  {
+    m_Stats.UnlabeledMarkerCapacity = static_cast< int32 >( rCachedMarker.MaxCount );
+  }
+  if (!rCachedMarker.SubjectPresent || bResized)
   {
     rCachedMarker.SubjectPresent = true;
-    if (NewMax)
-    {
-      rCachedMarker.MaxCount = MarkerCount;
-    }
-    FLiveLinkStaticDataStruct StaticDataStruct( FLiveLinkBaseStaticData::StaticStruct() );
-    FLiveLinkBaseStaticData& rMarkerStaticData = *StaticDataStruct.Cast< FLiveLinkBaseStaticData >();
-    // Property names are generated from marker indices as markers are only named when associated with a Vicon subject
-    rMarkerStaticData.PropertyNames = GetGenericMarkerPropertyNames(rCachedMarker.MaxCount);
-    m_pLiveLinkClient->PushSubjectStaticData_AnyThread( SubjectKey, ULiveLinkBasicRole::StaticClass(), MoveTemp( StaticDataStruct ) );
+    FLiveLinkStaticDataStruct StaticDataStruct( FLiveLinkViconPointCloudStaticData::StaticStruct() );
+    FLiveLinkViconPointCloudStaticData& rMarkerStaticData = *StaticDataStruct.Cast< FLiveLinkViconPointCloudStaticData >();
+    // No basic properties: a lone count would look like the [n, x1, y1, z1, ...] layout of subject markers
+    // to Get Marker Translations, which would then read points which are not there
+    rMarkerStaticData.Capacity = static_cast< int32 >( rCachedMarker.MaxCount );
+    m_pLiveLinkClient->PushSubjectStaticData_AnyThread( SubjectKey, ULiveLinkViconPointCloudRole::StaticClass(), MoveTemp( StaticDataStruct ) );
   }
 
   // Frame Data
-  FLiveLinkFrameDataStruct FrameDataStruct( FLiveLinkBaseFrameData::StaticStruct() );
-  FLiveLinkBaseFrameData& rMarkerFrameData = *FrameDataStruct.Cast< FLiveLinkBaseFrameData >();
-  // Get property values
-  TArray<float>& rPropertyValues = rMarkerFrameData.PropertyValues;
-  rPropertyValues.Init(0, 3 * rCachedMarker.MaxCount + 1);
-  // Markers are in the format [n, x1, y1, z1 ... xn, yn, zn, 0, 0, 0 ... , 0, 0, 0]
-  // We have a function LiveLinkViconUtils::GetMarkerTranslation to extract the data to a TArray<FVector>
-  rPropertyValues[0] = static_cast<float>(MarkerCount);
+  FLiveLinkFrameDataStruct FrameDataStruct( FLiveLinkViconPointCloudFrameData::StaticStruct() );
+  FLiveLinkViconPointCloudFrameData& rMarkerFrameData = *FrameDataStruct.Cast< FLiveLinkViconPointCloudFrameData >();
+  const int32 Capacity = static_cast< int32 >( rCachedMarker.MaxCount );
+  const int32 NumMarkers = static_cast< int32 >( MarkerCount );
+  rMarkerFrameData.MarkerCount = NumMarkers;
+  if( i_rContext.bHasTimecode )
+  {
+    rMarkerFrameData.MetaData.SceneTime = i_rContext.SceneTime;
+  }
+  rMarkerFrameData.Points.SetNumUninitialized( Capacity );
+  rMarkerFrameData.Valid.SetNumUninitialized( Capacity );
+  // The markers of the frame fill the first points, the rest are invalid
+  FMemory::Memset( rMarkerFrameData.Valid.GetData(), 1, NumMarkers * sizeof( bool ) );
+  FMemory::Memset( rMarkerFrameData.Valid.GetData() + NumMarkers, 0, ( Capacity - NumMarkers ) * sizeof( bool ) );
+  FMemory::Memzero( rMarkerFrameData.Points.GetData() + NumMarkers, ( Capacity - NumMarkers ) * sizeof( FVector3f ) );
   if (MarkerCount > 0)
   {
-    TArrayView<float> PropertyValuesView(&rPropertyValues[1], MarkerCount * 3);
-    const auto TranslationResult = bLabeled ?
-      m_DataStream.GetLabeledMarkers(PropertyValuesView) : m_DataStream.GetUnlabeledMarkers(PropertyValuesView);
-    if (TranslationResult == EResult::EError)
+    if (!i_rMarkers.bTranslationsValid)
     {
-      UE_LOG(LogViconStream, Warning, TEXT("Failed to get markers translations for %s"), *SubjectName);
+      UE_LOG(LogViconStream, Warning, TEXT("Failed to get markers translations for %s"), *SubjectName.ToString());
       return;
     }
+    // The points are written as flattened [x1, y1, z1, x2, ...] floats
+    static_assert( sizeof( FVector3f ) == 3 * sizeof( float ), "FVector3f must be three packed floats" );
+    TArrayView< float > PointsView( reinterpret_cast< float* >( rMarkerFrameData.Points.GetData() ), NumMarkers * 3 );
+    m_DataStream.GetMarkers( i_rContext, i_rMarkers, PointsView );
+  }
+
+  // Unlabeled markers come in arbitrary order, so give them ids which persist from frame to frame
+  if( !bLabeled )
+  {
+    if( m_bTrackUnlabeledMarkers )
+    {
+      rMarkerFrameData.Ids.SetNumUninitialized( Capacity );
+      m_UnlabeledMarkerTracker.Track( MakeArrayView( rMarkerFrameData.Points.GetData(), NumMarkers ), m_UnlabeledMarkerGateDistance,
+                                      MakeArrayView( rMarkerFrameData.Ids.GetData(), NumMarkers ) );
+      for( int32 PointIndex = NumMarkers; PointIndex < Capacity; ++PointIndex )
+      {
+        rMarkerFrameData.Ids[ PointIndex ] = INDEX_NONE;
+      }
+      m_Stats.UnlabeledMarkerTracks = m_UnlabeledMarkerTracker.NumTracks();
+    }
+    else if( m_UnlabeledMarkerTracker.NumTracks() != 0 )
+    {
+      m_UnlabeledMarkerTracker.Reset();
+      m_Stats.UnlabeledMarkerTracks = 0;
+    }
+  }
+
+  if( io_pMarkerIndex )
+  {
+    const TArrayView< const int32 > Ids = rMarkerFrameData.Ids.Num() > 0 ? TArrayView< const int32 >( rMarkerFrameData.Ids.GetData(), NumMarkers ) : TArrayView< const int32 >();
+    io_pMarkerIndex->AddSubject( SubjectName, MakeArrayView( rMarkerFrameData.Points.GetData(), NumMarkers ), Ids );
   }
   m_pLiveLinkClient->PushSubjectFrameData_AnyThread(SubjectKey, MoveTemp( FrameDataStruct ) );
 
 }
 
-// todo: reference instead of the pointer
-void FViconStreamFrameReader::HandleSubjectData()
+FViconMarkerIndex* FViconStreamFrameReader::BeginMarkerIndex( const FViconFrameContext& i_rContext )
+{
+  if( !m_bPublishMarkerIndex )
+  {
+    WithdrawMarkerIndex();
+    return nullptr;
+  }
+
+  // Queries hold a reference to the index they search, so an index is only rebuilt in place once they let go
+  if( !m_MarkerIndex.IsValid() || !m_MarkerIndex.IsUnique() )
+  {
+    m_MarkerIndex = MakeShared< FViconMarkerIndex, ESPMode::ThreadSafe >();
+  }
+  m_MarkerIndex->Reset( i_rContext.FrameNumber );
+  return m_MarkerIndex.Get();
+}
+
+void FViconStreamFrameReader::PublishMarkerIndex()
+{
+  SCOPE_CYCLE_COUNTER( STAT_ViconMarkerIndexBuild );
+  m_MarkerIndex->Build();
+  m_Stats.IndexedMarkers = m_MarkerIndex->NumMarkers();
+  FViconMarkerIndexRegistry::Publish( this, m_MarkerIndex );
+  // The previous index is reused for the next frame once nothing refers to it
+  Swap( m_MarkerIndex, m_PublishedMarkerIndex );
+}
+
+void FViconStreamFrameReader::WithdrawMarkerIndex()
+{
+  if( m_PublishedMarkerIndex.IsValid() )
+  {
+    FViconMarkerIndexRegistry::Publish( this, nullptr );
+    m_PublishedMarkerIndex.Reset();
+    m_MarkerIndex.Reset();
+    m_Stats.IndexedMarkers = 0;
+  }
+}
+
+bool FViconStreamFrameReader::UpdateMarkerCapacity( FCachedMarker& io_rCachedMarker, unsigned int i_MarkerCount, double i_NowSeconds )
+{
+  unsigned int NewCapacity = io_rCachedMarker.MaxCount;
+  if( i_MarkerCount > io_rCachedMarker.MaxCount )
+  {
+    // Markers must never be dropped, so growing is not rate limited
+    NewCapacity = i_MarkerCount;
+  }
+  else if( i_MarkerCount <= io_rCachedMarker.MaxCount * s_MarkerShrinkThreshold )
+  {
+    if( io_rCachedMarker.BelowThresholdSinceSeconds < 0.0 )
+    {
+      io_rCachedMarker.BelowThresholdSinceSeconds = i_NowSeconds;
+      io_rCachedMarker.PeakCountBelowThreshold = i_MarkerCount;
+    }
+    io_rCachedMarker.PeakCountBelowThreshold = FMath::Max( io_rCachedMarker.PeakCountBelowThreshold, i_MarkerCount );
+
+    if( i_NowSeconds - io_rCachedMarker.BelowThresholdSinceSeconds >= s_MarkerShrinkDelaySeconds &&
+        i_NowSeconds - io_rCachedMarker.LastResizeSeconds >= s_MarkerResizeMinIntervalSeconds )
+    {
+      NewCapacity = static_cast< unsigned int >( FMath::CeilToDouble( io_rCachedMarker.PeakCountBelowThreshold * ( 1.0 + s_MarkerShrinkHeadroom ) ) );
+    }
+  }
+  else
+  {
+    io_rCachedMarker.BelowThresholdSinceSeconds = -1.0;
+  }
+
+  if( NewCapacity == io_rCachedMarker.MaxCount )
+  {
+    return false;
+  }
+  io_rCachedMarker.MaxCount = NewCapacity;
+  io_rCachedMarker.BelowThresholdSinceSeconds = -1.0;
+  io_rCachedMarker.LastResizeSeconds = i_NowSeconds;
+  ++m_Stats.MarkerCapacityResizes;
+  INC_DWORD_STAT( STAT_ViconMarkerCapacityResizes );
+  return true;
+}
+
+void FViconStreamFrameReader::HandleSubjectData( FViconRawFrame& io_rFrame )
 {
-  TArray< FString > SubjectNames;
+  TArray< FViconNameId > SubjectNames;
   if( m_DataStream.GetSubjectNames( SubjectNames ) != EResult::ESuccess )
   {
     return;
   }
  
+  const double NowSeconds = FPlatformTime::Seconds();
+  UpdateComponentSpaceSubjects( io_rFrame );
+
   // static data (skeleton)
-  for( const auto& rSubject : SubjectNames )
+  for( int32 SubjectIndex = 0; SubjectIndex < SubjectNames.Num(); ++SubjectIndex )
   {
+    const FViconNameId Subject = SubjectNames[ SubjectIndex ];
+
     // Bail out immediately if we're closing down
     if( m_bStopTask )
     {
       return;
     }
 
-    if( m_SubjectAllowed.Num() != 0 && !m_SubjectAllowed.Contains( rSubject ) )
+    if( m_SubjectAllowed.Num() != 0 && !m_SubjectAllowed.Contains( Subject ) )
     {
       continue;
     }
 
-    FName SubjectNameFName = FName( *rSubject );
-    // If we have the subject cached, check the bone count or marker count have not changed.  
-    // If either did, remove the subject and re-add the static data data
-    // We do this because the bone count determines whether it is a transform or an animation role
-    // And the marker property names need to change when markers are enabled / disabled or the subject has been altered
-    if( m_CachedSubjects.Contains( rSubject ))
+    // If we have the subject cached, check its schema has not changed. If it did, remove the subject and
+    // re-add the static data.
+    if( FCachedSubject* pCachedSubject = m_CachedSubjects.Find( Subject ) )
     {
-      const FCachedSubject& CachedSubject = m_CachedSubjects[ rSubject ];
-      unsigned int StreamBoneCount = 0;
-      TArray<std::string> StreamMarkerNames;
-      if( m_DataStream.GetSegmentCountForSubject( TCHAR_TO_UTF8( *rSubject ), StreamBoneCount ) == ESuccess  &&
-          m_DataStream.GetMarkerNamesForSubject( TCHAR_TO_UTF8( *rSubject ), StreamMarkerNames ) == ESuccess  )
+      if( ValidateCachedSubject( SubjectIndex, *pCachedSubject ) )
       {
-        // std::vector equality checks for matching lengths first so it should be efficient
-        if( StreamBoneCount == CachedSubject.Bones.Num() && StreamMarkerNames == CachedSubject.Markers )
-        {
-          // Move on to next subject, don't need to update static data
-          continue;
-        }
-        else
-        {
-          UE_LOG( LogViconStream, Warning, TEXT( "Bone count or marker names changed for %s" ), *rSubject );
-          if( !m_bStopTask )
-          {
-            m_pLiveLinkClient->RemoveSubject_AnyThread( {m_SourceGuid, SubjectNameFName} );
-          }
-          m_CachedSubjects.Remove( rSubject );
-        }
+        // Move on to next subject, don't need to update static data
+        pCachedSubject->LastSeenSeconds = NowSeconds;
+        continue;
+      }
+      io_rFrame.RemovedSubjects.Add( pCachedSubject->Name->LiveLinkName );
+      if( m_bComponentSpacePosesApplied )
+      {
+        io_rFrame.RemovedSubjects.Add( pCachedSubject->Name->ComponentSpaceName );
       }
+      m_CachedSubjects.Remove( Subject );
     }
 
     // If we don't have the subject cached, we will add it below
     FCachedSubject CachedSubject;
-    bool bGotSkeleton = AddSubjectStaticDataToLiveLink( rSubject, CachedSubject.Bones, CachedSubject.Markers);
+    bool bGotSkeleton = AddSubjectStaticDataToLiveLink( Subject, CachedSubject, io_rFrame );
     if ( !bGotSkeleton )
     {
-      UE_LOG( LogViconStream, Error, TEXT( "Failed to get Static Data for %s" ), *rSubject );
+      UE_LOG( LogViconStream, Error, TEXT( "Failed to get Static Data for %s" ), *FViconNamePool::Get().GetString( Subject ) );
       continue;
     }
-    m_CachedSubjects.Add( rSubject, CachedSubject );
+    CachedSubject.PoseCache = MakeShared< FViconSubjectPoseCache, ESPMode::ThreadSafe >( CachedSubject.Schema->Template->Bones.Num() );
+    CachedSubject.LastSeenSeconds = NowSeconds;
+    CachedSubject.SubjectIndex = SubjectIndex;
+    CachedSubject.SegmentCount = CachedSubject.Schema->Template->Bones.Num();
+    CachedSubject.MarkerCount = CachedSubject.Schema->Template->Markers.Num();
+    ScheduleSchemaAudit( CachedSubject );
+    m_CachedSubjects.Add( Subject, CachedSubject );
+    m_bSchemaCacheDirty = true;
+    m_Stats.SkeletonTemplates = m_SkeletonTemplates.Num();
+  }
+
+  if( m_bWarmStartPending )
+  {
+    RemoveUnconfirmedWarmStartSubjects( io_rFrame );
   }
 
   // frame data
-  for ( const auto& rSubject : SubjectNames )
+  for ( const FViconNameId Subject : SubjectNames )
+  {
+    if ( m_SubjectAllowed.Num() != 0 && !m_SubjectAllowed.Contains(Subject) )
+    {
+      continue;
+    }
+
+    const FCachedSubject* pCachedSubject = m_CachedSubjects.Find( Subject );
+    if( !pCachedSubject )
+    {
+      continue;
+    }
+
+    FViconRawSubject& rRawSubject = io_rFrame.AddSubject();
+    rRawSubject.Name = pCachedSubject->Name;
+    rRawSubject.PoseCache = pCachedSubject->PoseCache;
+    rRawSubject.Schema = pCachedSubject->Schema;
+    if( !m_DataStream.CaptureSubject( rRawSubject ) )
+    {
+      io_rFrame.DiscardLastSubject();
+    }
+  }
+
+  PruneCachedSubjects( NowSeconds );
+}
+
+bool FViconStreamFrameReader::ValidateCachedSubject( int32 i_SubjectIndex, FCachedSubject& io_rCachedSubject )
+{
+  const std::string& SubjectName = io_rCachedSubject.Name->Utf8();
+
+  // The bone count determines whether it is a transform or an animation role, and the marker property
+  // names need to change when markers are enabled / disabled or the subject has been altered.
+  // Counts are cheap to get from the SDK; a subject moving in the subject list hints that subjects were
+  // added or removed, which is often when a subject is reloaded.
+  unsigned int SegmentCount = 0;
+  unsigned int MarkerCount = 0;
+  const bool bGotCounts = m_DataStream.GetSegmentCountForSubject( SubjectName, SegmentCount ) == ESuccess &&
+                          m_DataStream.GetMarkerCountForSubject( SubjectName, MarkerCount ) == ESuccess;
+  if( !bGotCounts )
+  {
+    // Keep what we have rather than churning the subject on a transient failure
+    return true;
+  }
+
+  const bool bFingerprintChanged = SegmentCount != io_rCachedSubject.SegmentCount ||
+                                   MarkerCount != io_rCachedSubject.MarkerCount ||
+                                   i_SubjectIndex != io_rCachedSubject.SubjectIndex;
+  // Names can change without the counts changing, e.g. a subject swapped for another with the same layout
+  const bool bAuditDue = FPlatformTime::Seconds() >= io_rCachedSubject.NextAuditSeconds;
+  if( !bFingerprintChanged && !bAuditDue )
+  {
+    return true;
+  }
+
+  if( bFingerprintChanged )
+  {
+    ++m_Stats.SchemaRevalidations;
+    INC_DWORD_STAT( STAT_ViconSchemaRevalidations );
+  }
+  else
+  {
+    ++m_Stats.SchemaAudits;
+    INC_DWORD_STAT( STAT_ViconSchemaAudits );
+  }
+
+  const FViconSubjectSchema& CachedSchema = *io_rCachedSubject.Schema;
+  const FViconSkeletonTemplate& CachedTemplate = *CachedSchema.Template;
+  bool bSchemaMatches = static_cast< int32 >( SegmentCount ) == CachedTemplate.Bones.Num();
+  TArray< FViconNameId > StreamMarkerNames;
+  if( bSchemaMatches && m_DataStream.GetMarkerNamesForSubject( SubjectName, StreamMarkerNames ) == ESuccess )
+  {
+    bSchemaMatches = StreamMarkerNames == CachedTemplate.Markers;
+  }
+  for( int32 BoneIndex = 0; bSchemaMatches && BoneIndex < CachedTemplate.Bones.Num(); ++BoneIndex )
+  {
+    FViconNameId BoneName;
+    if( m_DataStream.GetSegmentNameForSubject( SubjectName, BoneIndex, BoneName ) == ESuccess )
+    {
+      bSchemaMatches = CachedTemplate.Bones[ BoneIndex ] == BoneName;
+    }
+  }
+
+  // Parents are only read from the SDK when the static data is built, so a schema from disk has its own check
+  for( int32 BoneIndex = 0; bSchemaMatches && io_rCachedSubject.bFromSchemaCache && CachedTemplate.Bones.Num() > 1 && BoneIndex < CachedTemplate.Bones.Num(); ++BoneIndex )
+  {
+    FViconNameId ParentName;
+    if( m_DataStream.GetSegmentParentNameForSubject( SubjectName, FViconNamePool::Get().GetUtf8( CachedTemplate.Bones[ BoneIndex ] ), ParentName ) == ESuccess )
+    {
+      const int32 Parent = CachedTemplate.BoneParents[ BoneIndex ];
+      bSchemaMatches = ( Parent == INDEX_NONE ) ? !CachedTemplate.Bones.Contains( ParentName ) : CachedTemplate.Bones[ Parent ] == ParentName;
+    }
+  }
+
+  // The scale tables are part of the schema, so a recalibrated subject gets new ones. The hierarchy scales are
+  // products of the static scales, so comparing those is enough and costs one SDK call per bone.
+  if( bSchemaMatches )
+  {
+    TArray< FVector > StaticScales;
+    m_DataStream.GetStaticScales( SubjectName, CachedTemplate.Bones, StaticScales );
+    bSchemaMatches = StaticScales.Num() == CachedSchema.StaticScales.Num();
+    for( int32 BoneIndex = 0; bSchemaMatches && BoneIndex < StaticScales.Num(); ++BoneIndex )
+    {
+      bSchemaMatches = StaticScales[ BoneIndex ].Equals( CachedSchema.StaticScales[ BoneIndex ] );
+    }
+  }
+
+  if( !bSchemaMatches )
+  {
+    UE_LOG( LogViconStream, Warning, TEXT( "Bone count or names, marker names or segment scales changed for %s" ), *io_rCachedSubject.Name->Name() );
+    if( io_rCachedSubject.bFromSchemaCache )
+    {
+      ++m_Stats.SchemaCacheMisses;
+    }
+    ++m_Stats.SchemaChanges;
+    INC_DWORD_STAT( STAT_ViconSchemaChanges );
+    return false;
+  }
+
+  // Same schema, e.g. another subject was added before this one. Remember the new fingerprint.
+  if( io_rCachedSubject.bFromSchemaCache )
+  {
+    io_rCachedSubject.bFromSchemaCache = false;
+    ++m_Stats.SchemaCacheHits;
+  }
+  io_rCachedSubject.SubjectIndex = i_SubjectIndex;
+  ScheduleSchemaAudit( io_rCachedSubject );
+  return true;
+}
+
+void FViconStreamFrameReader::PruneCachedSubjects( double i_NowSeconds )
+{
+  if( i_NowSeconds < m_NextSubjectPruneSeconds )
+  {
+    return;
+  }
+  m_NextSubjectPruneSeconds = i_NowSeconds + s_SubjectPruneIntervalSeconds;
+
+  // The subjects are left in LiveLink, as before. If a subject comes back its static data is sent again.
+  for( auto It = m_CachedSubjects.CreateIterator(); It; ++It )
+  {
+    if( i_NowSeconds - It.Value().LastSeenSeconds > s_SubjectExpirySeconds )
+    {
+      UE_LOG( LogViconStream, Log, TEXT( "Forgetting subject %s, not in the stream for %.0f s" ), *It.Value().Name->Name(), s_SubjectExpirySeconds );
+      m_Names.Remove( It.Key() );
+      It.RemoveCurrent();
+      m_bSchemaCacheDirty = true;
+    }
+  }
+
+  // Raw frames still being converted may hold on to a template, in which case it goes on the next prune
+  m_SkeletonTemplates.Prune();
+  m_Stats.SkeletonTemplates = m_SkeletonTemplates.Num();
+}
+
+void FViconStreamFrameReader::WarmStartFromSchemaCache()
+{
+  m_SchemaCachePath = FViconSchemaCache::GetFilePath( ConstructServerAddress(), m_SubjectPrefix );
+
+  TArray< FViconCachedSchema > CachedSchemas;
+  if( !FViconSchemaCache::Load( m_SchemaCachePath, m_SkeletonTemplates, CachedSchemas ) )
+  {
+    return;
+  }
+
+  // The subject filter is only applied to m_SubjectAllowed once connected
+  const TSet< FViconNameId > SubjectAllowed = ParseSubjectFilter();
+
+  const double NowSeconds = FPlatformTime::Seconds();
+  for( const FViconCachedSchema& rCachedSchema : CachedSchemas )
   {
-    if ( m_SubjectAllowed.Num() != 0 && !m_SubjectAllowed.Contains(rSubject) )
+    if( m_bStopTask )
+    {
+      return;
+    }
+    if( SubjectAllowed.Num() != 0 && !SubjectAllowed.Contains( rCachedSchema.SubjectName ) )
     {
       continue;
     }
 
-    FName SubjectNameFName = FName( *rSubject );
-    const FCachedSubject& CachedSubject = m_CachedSubjects[ rSubject ];
-    FLiveLinkFrameDataStruct FrameDataStruct = ( CachedSubject.Bones.Num() == 1 ) ?
+    // The subject index can't match the stream's, so the whole schema is compared with the stream on the first frame
+    FCachedSubject CachedSubject;
+    CachedSubject.Name = m_Names.FindOrAdd( rCachedSchema.SubjectName );
+    CachedSubject.Schema = rCachedSchema.Schema;
+    CachedSubject.PoseCache = MakeShared< FViconSubjectPoseCache, ESPMode::ThreadSafe >( CachedSubject.Schema->Template->Bones.Num() );
+    CachedSubject.LastSeenSeconds = NowSeconds;
+    CachedSubject.SegmentCount = CachedSubject.Schema->Template->Bones.Num();
+    CachedSubject.MarkerCount = CachedSubject.Schema->Template->Markers.Num();
+    CachedSubject.bFromSchemaCache = true;
+
+    // Nothing has been committed to the frame ring yet, so this can't overtake static data or removals sent by the conversion thread
+    FViconStaticDataUpdate Update = MakeSubjectStaticData( *CachedSubject.Name, *CachedSubject.Schema );
+    m_pLiveLinkClient->PushSubjectStaticData_AnyThread( {m_SourceGuid, Update.SubjectName}, Update.Role, MoveTemp( Update.StaticData ) );
+    m_CachedSubjects.Add( rCachedSchema.SubjectName, MoveTemp( CachedSubject ) );
+    ++m_Stats.SchemaCacheWarmStarts;
+    m_bWarmStartPending = true;
+  }
+
+  m_Stats.SkeletonTemplates = m_SkeletonTemplates.Num();
+  UE_LOG( LogViconStream, Display, TEXT( "Pushed %d subjects, using %d skeletons, from schema cache %s" ),
+          m_CachedSubjects.Num(), m_Stats.SkeletonTemplates.load(), *m_SchemaCachePath );
+}
+
+void FViconStreamFrameReader::RemoveUnconfirmedWarmStartSubjects( FViconRawFrame& io_rFrame )
+{
+  m_bWarmStartPending = false;
+
+  // Subjects in the stream have been validated, which clears bFromSchemaCache. The rest were renamed or deleted
+  // since the cache was written, and would otherwise stay in LiveLink with static data but never a frame.
+  for( auto It = m_CachedSubjects.CreateIterator(); It; ++It )
+  {
+    const FCachedSubject& rCachedSubject = It.Value();
+    if( !rCachedSubject.bFromSchemaCache )
+    {
+      continue;
+    }
+    UE_LOG( LogViconStream, Log, TEXT( "Removing subject %s from the schema cache, not in the stream" ), *rCachedSubject.Name->Name() );
+    io_rFrame.RemovedSubjects.Add( rCachedSubject.Name->LiveLinkName );
+    if( m_bComponentSpacePosesApplied )
+    {
+      io_rFrame.RemovedSubjects.Add( rCachedSubject.Name->ComponentSpaceName );
+    }
+    ++m_Stats.SchemaCacheMisses;
+    m_Names.Remove( It.Key() );
+    It.RemoveCurrent();
+    m_bSchemaCacheDirty = true;
+  }
+}
+
+void FViconStreamFrameReader::SaveSchemaCache( bool i_bBlocking )
+{
+  // Writes to the same file must not overlap, and none may be left running once the reader stops
+  if( m_SchemaCacheSave.IsValid() && ( i_bBlocking || m_bSchemaCacheDirty ) )
+  {
+    m_SchemaCacheSave.Wait();
+  }
+  if( !m_bSchemaCacheDirty || m_SchemaCachePath.IsEmpty() )
+  {
+    return;
+  }
+  m_bSchemaCacheDirty = false;
+  m_NextSchemaCacheSaveSeconds = FPlatformTime::Seconds() + s_SchemaCacheSaveIntervalSeconds;
+
+  TArray< FViconCachedSchema > CachedSchemas;
+  CachedSchemas.Reserve( m_CachedSubjects.Num() );
+  for( const auto& rCachedSubject : m_CachedSubjects )
+  {
+    CachedSchemas.Add( {rCachedSubject.Key, rCachedSubject.Value.Schema} );
+  }
+
+  TArray< uint8 > Bytes;
+  FViconSchemaCache::Encode( CachedSchemas, Bytes );
+  if( i_bBlocking )
+  {
+    FViconSchemaCache::Save( m_SchemaCachePath, Bytes );
+  }
+  else
+  {
+    m_SchemaCacheSave = Async( EAsyncExecution::ThreadPool, [ Path = m_SchemaCachePath, Bytes = MoveTemp( Bytes ) ]()
+    {
+      return FViconSchemaCache::Save( Path, Bytes );
+    } );
+  }
+}
+
+void FViconStreamFrameReader::ScheduleSchemaAudit( FCachedSubject& io_rCachedSubject ) const
+{
+  const int32 Slot = FMath::Max( io_rCachedSubject.SubjectIndex, 0 ) % s_SchemaAuditSlots;
+  io_rCachedSubject.NextAuditSeconds = FPlatformTime::Seconds() + s_SchemaAuditIntervalSeconds * ( 1.0 + double( Slot ) / s_SchemaAuditSlots );
+}
+
+void FViconStreamFrameReader::PushSubjectData( const FViconRawFrame& i_rFrame )
+{
+  const int32 NumSubjects = i_rFrame.NumSubjects;
+  m_SubjectFrameData.SetNum( NumSubjects, false );
+  m_SubjectConverted.SetNum( NumSubjects, false );
+  m_SubjectComponentSpaceData.SetNum( i_rFrame.bComponentSpacePoses ? NumSubjects : 0, false );
+  m_SubjectHasComponentSpace.SetNum( NumSubjects, false );
+
+  auto ConvertSubject = [ this, &i_rFrame ]( int32 SubjectIndex )
+  {
+    const FViconRawSubject& rRawSubject = i_rFrame.Subjects[ SubjectIndex ];
+    const FViconSkeletonTemplate& rTemplate = *rRawSubject.Schema->Template;
+    FLiveLinkFrameDataStruct& rFrameDataStruct = m_SubjectFrameData[ SubjectIndex ];
+    rFrameDataStruct = ( rTemplate.Bones.Num() == 1 ) ?
       FLiveLinkFrameDataStruct( FLiveLinkTransformFrameData::StaticStruct() ) :
       FLiveLinkFrameDataStruct( FLiveLinkAnimationFrameData::StaticStruct() );
-    if (m_DataStream.GetPoseForSubject(TCHAR_TO_UTF8(*rSubject), CachedSubject.Bones, CachedSubject.Markers, FrameDataStruct))
+    m_SubjectConverted[ SubjectIndex ] = m_DataStream.GetPoseForSubject( i_rFrame.Context, rRawSubject, rFrameDataStruct );
+
+    // Compose the local poses while they are still in cache, rather than asking the SDK for the global ones
+    m_SubjectHasComponentSpace[ SubjectIndex ] = false;
+    if( i_rFrame.bComponentSpacePoses && m_SubjectConverted[ SubjectIndex ] && rTemplate.Bones.Num() > 1 && rTemplate.SolveOrder.Num() != 0 )
     {
-      if( !m_bStopTask )
+      const FLiveLinkAnimationFrameData& rLocalData = *rFrameDataStruct.Cast< FLiveLinkAnimationFrameData >();
+      if( rLocalData.Transforms.Num() == rTemplate.Bones.Num() )
       {
-        m_pLiveLinkClient->PushSubjectFrameData_AnyThread( {m_SourceGuid, SubjectNameFName}, MoveTemp( FrameDataStruct ) );
-        UE_LOG( LogViconStream, Log, TEXT( "Adding data for %s" ), *rSubject );
+        FLiveLinkFrameDataStruct& rComponentSpaceStruct = m_SubjectComponentSpaceData[ SubjectIndex ];
+        rComponentSpaceStruct = FLiveLinkFrameDataStruct( FLiveLinkAnimationFrameData::StaticStruct() );
+        FLiveLinkAnimationFrameData& rComponentSpaceData = *rComponentSpaceStruct.Cast< FLiveLinkAnimationFrameData >();
+        rComponentSpaceData.WorldTime = rLocalData.WorldTime;
+        rComponentSpaceData.MetaData = rLocalData.MetaData;
+        rComponentSpaceData.Transforms.SetNumUninitialized( rLocalData.Transforms.Num() );
+        FViconPoseKernel::LocalToComponentSpace( rLocalData.Transforms, rTemplate.BoneParents, rTemplate.SolveOrder, rComponentSpaceData.Transforms );
+        m_SubjectHasComponentSpace[ SubjectIndex ] = true;
+      }
+    }
+  };
+
+  // Split the subjects into contiguous batches, one per worker. The conversion thread runs one of the batches itself.
+  const int32 NumBatches = FMath::Min( m_SubjectConversionWorkers.GetValue(), NumSubjects );
+  if( NumBatches > 1 )
+  {
+    const int32 BatchSize = FMath::DivideAndRoundUp( NumSubjects, NumBatches );
+    ParallelFor( NumBatches, [ &ConvertSubject, BatchSize, NumSubjects ]( int32 BatchIndex )
+    {
+      const int32 End = FMath::Min( ( BatchIndex + 1 ) * BatchSize, NumSubjects );
+      for( int32 SubjectIndex = BatchIndex * BatchSize; SubjectIndex < End; ++SubjectIndex )
+      {
+        ConvertSubject( SubjectIndex );
+      }
+    } );
+  }
+  else
+  {
+    for( int32 SubjectIndex = 0; SubjectIndex < NumSubjects; ++SubjectIndex )
+    {
+      ConvertSubject( SubjectIndex );
+    }
+  }
+
+  // Push in subject order, regardless of the order the conversions finished in
+  for( int32 SubjectIndex = 0; SubjectIndex < NumSubjects; ++SubjectIndex )
+  {
+    if( m_SubjectConverted[ SubjectIndex ] && !m_bStopTask )
+    {
+      const FName SubjectName = i_rFrame.Subjects[ SubjectIndex ].Name->LiveLinkName;
+      m_pLiveLinkClient->PushSubjectFrameData_AnyThread( {m_SourceGuid, SubjectName}, MoveTemp( m_SubjectFrameData[ SubjectIndex ] ) );
+      UE_LOG( LogViconStream, Log, TEXT( "Adding data for %s" ), *SubjectName.ToString() );
+      if( m_SubjectHasComponentSpace[ SubjectIndex ] )
+      {
+        const FName ComponentSpaceName = i_rFrame.Subjects[ SubjectIndex ].Name->ComponentSpaceName;
+        m_pLiveLinkClient->PushSubjectFrameData_AnyThread( {m_SourceGuid, ComponentSpaceName}, MoveTemp( m_SubjectComponentSpaceData[ SubjectIndex ] ) );
       }
     }
   }
 }
 
-void FViconStreamFrameReader::HandleCameraData()
+void FViconStreamFrameReader::HandleCameraData( FViconRawFrame& io_rFrame )
 {
   // get all video camera from datastream
-  TSet< FString > CameraNameList;
+  TSet< FViconNameId > CameraNameList;
 
   EResult Result;
   if( m_bShowAllVideoCamera )
@@ -601,185 +1707,244 @@ void FViconStreamFrameReader::HandleCameraData()
   {
     return;
   }
+  io_rFrame.bHasCameraData = true;
 
-  TSet< FString > NotInDataStreamAnyMore = m_CachedCameras.Difference( CameraNameList );
+  TSet< FViconNameId > NotInDataStreamAnyMore = m_CachedCameras.Difference( CameraNameList );
   if( NotInDataStreamAnyMore.Num() != 0 )
   {
-    ClearCamerasFromLiveLink( NotInDataStreamAnyMore );
+    ClearCamerasFromLiveLink( NotInDataStreamAnyMore, io_rFrame );
   }
 
-  TSet< FString > NewCameras = CameraNameList.Difference( m_CachedCameras );
+  TSet< FViconNameId > NewCameras = CameraNameList.Difference( m_CachedCameras );
 
   if( NewCameras.Num() != 0 )
   {
-    for( const auto& rCamera : NewCameras )
+    for( const FViconNameId rCamera : NewCameras )
     {
-      FName CameraName( *rCamera );
-      FLiveLinkStaticDataStruct StaticDataStruct = FLiveLinkStaticDataStruct( FLiveLinkLensStaticData::StaticStruct() );
-      FLiveLinkLensStaticData& rLensData = *StaticDataStruct.Cast< FLiveLinkLensStaticData >();
-
-      if( EError == m_DataStream.GetLensStaticData( TCHAR_TO_UTF8( *rCamera ), rLensData ) )
+      FViconStaticDataUpdate& rUpdate = io_rFrame.StaticDataUpdates.AddDefaulted_GetRef();
+      const FViconNamePtr CameraName = m_Names.FindOrAdd( rCamera );
+      rUpdate.SubjectName = CameraName->LiveLinkName;
+      rUpdate.Role = ULiveLinkLensRole::StaticClass();
+      rUpdate.StaticData = FLiveLinkStaticDataStruct( FLiveLinkLensStaticData::StaticStruct() );
+      FLiveLinkLensStaticData& rLensData = *rUpdate.StaticData.Cast< FLiveLinkLensStaticData >();
+
+      if( EError == m_DataStream.GetLensStaticData( CameraName->Utf8(), rLensData ) )
       {
-        UE_LOG( LogViconStream, Error, TEXT( "Failed to retrieve static data for %s" ), *rCamera );
+        UE_LOG( LogViconStream, Error, TEXT( "Failed to retrieve static data for %s" ), *CameraName->Name() );
       }
-      // push the data into livelink
-      m_pLiveLinkClient->PushSubjectStaticData_AnyThread( {m_SourceGuid, CameraName}, ULiveLinkLensRole::StaticClass(), MoveTemp( StaticDataStruct ) );
       m_CachedCameras.Add( rCamera );
     }
   }
 
-  // push frame data for all camera
-  for( const auto& rCamera : CameraNameList )
+  // capture frame data for all camera
+  for( const FViconNameId rCamera : CameraNameList )
   {
     if( m_bStopTask )
     {
       return;
     }
 
-    FName CameraName( *rCamera );
-
-    // camera frame data
-    FLiveLinkFrameDataStruct FrameDataStruct = FLiveLinkFrameDataStruct( FLiveLinkLensFrameData::StaticStruct() );
-    FLiveLinkLensFrameData& rLensData = *FrameDataStruct.Cast< FLiveLinkLensFrameData >();
+    FViconRawCamera& rRawCamera = io_rFrame.AddCamera();
+    rRawCamera.Name = m_Names.FindOrAdd( rCamera );
 
     // check the result
-    if( EResult::EError == m_DataStream.GetCameraTransformFrameData( TCHAR_TO_UTF8( *rCamera ), rLensData ) )
+    if( EResult::EError == m_DataStream.CaptureCamera( rRawCamera.Name->Utf8(), rRawCamera ) )
     {
+      io_rFrame.DiscardLastCamera();
       return;
     }
-    if( EResult::EError == m_DataStream.GetLensFrameData( TCHAR_TO_UTF8( *rCamera ), rLensData ) )
+  }
+}
+
+void FViconStreamFrameReader::PushCameraData( const FViconRawFrame& i_rFrame )
+{
+  // push frame data for all camera
+  for( int32 CameraIndex = 0; CameraIndex < i_rFrame.NumCameras; ++CameraIndex )
+  {
+    if( m_bStopTask )
     {
       return;
     }
 
-    m_pLiveLinkClient->PushSubjectFrameData_AnyThread( {m_SourceGuid, CameraName}, MoveTemp( FrameDataStruct ) );
+    const FViconRawCamera& rRawCamera = i_rFrame.Cameras[ CameraIndex ];
+
+    // camera frame data
+    FLiveLinkFrameDataStruct FrameDataStruct = FLiveLinkFrameDataStruct( FLiveLinkLensFrameData::StaticStruct() );
+    FLiveLinkLensFrameData& rLensData = *FrameDataStruct.Cast< FLiveLinkLensFrameData >();
+
+    m_DataStream.GetCameraTransformFrameData( i_rFrame.Context, rRawCamera, rLensData );
+    m_DataStream.GetLensFrameData( i_rFrame.Context, rRawCamera, rLensData );
+
+    m_pLiveLinkClient->PushSubjectFrameData_AnyThread( {m_SourceGuid, rRawCamera.Name->LiveLinkName}, MoveTemp( FrameDataStruct ) );
   }
 }
 
 
-void FViconStreamFrameReader::HandleMarkerData()
+void FViconStreamFrameReader::HandleMarkerData( FViconRawFrame& io_rFrame )
 {
-  HandleMarkerData(true);
-  HandleMarkerData(false);
-}
+  io_rFrame.bHasMarkerData = true;
 
-TArray<FName> FViconStreamFrameReader::MarkerPropertiesFromNames(const TArray<std::string>& i_rMarkerNames)
-{
-  TArray<FName> MarkerProperties;
-  MarkerProperties.Emplace(MARKER_COUNT_PROPERTY.c_str());
-  for (const std::string& MarkerName : i_rMarkerNames)
+  io_rFrame.LabeledMarkers.bEnabled = m_bLabeledMarker;
+  if( m_bLabeledMarker )
   {
-    MarkerProperties.Emplace((MarkerName + "_X").c_str());
-    MarkerProperties.Emplace((MarkerName + "_Y").c_str());
-    MarkerProperties.Emplace((MarkerName + "_Z").c_str());
+    m_DataStream.CaptureLabeledMarkers( io_rFrame.LabeledMarkers );
+  }
+
+  io_rFrame.UnlabeledMarkers.bEnabled = m_bUnlabeledMarker;
+  if( m_bUnlabeledMarker )
+  {
+    m_DataStream.CaptureUnlabeledMarkers( io_rFrame.UnlabeledMarkers );
   }
-  return MarkerProperties;
 }
 
 // Bind the given subject to the given skeleton and store the result.
-bool FViconStreamFrameReader::AddSubjectStaticDataToLiveLink( const FString& i_rSubjectName, TArray< std::string >& o_rSubjectBones, TArray<std::string>& o_rMarkerNames )
+bool FViconStreamFrameReader::AddSubjectStaticDataToLiveLink( FViconNameId i_SubjectName, FCachedSubject& o_rCachedSubject, FViconRawFrame& io_rFrame )
 {
-  if( m_DataStream.IsConnected() )
+  if( !m_DataStream.IsConnected() )
   {
-    FName SubjectNameFName = FName( *i_rSubjectName );
-    int32 NumBoneDefs = INDEX_NONE;
+    return false;
+  }
 
-    unsigned int numBone = 0;
-    if( m_DataStream.GetSegmentCountForSubject( TCHAR_TO_UTF8( *i_rSubjectName ), numBone ) != ESuccess )
-    {
-      UE_LOG( LogViconStream, Error, TEXT( "Failed to get source skeleton segment count from Vicon Stream" ) );
-      return false;
-    }
-    // rigid body
-    if( numBone == 1 )
-    {
-      FLiveLinkStaticDataStruct StaticDataStruct = FLiveLinkStaticDataStruct( FLiveLinkTransformStaticData::StaticStruct() );
-      FLiveLinkTransformStaticData& StaticTransformData = *StaticDataStruct.Cast< FLiveLinkTransformStaticData >();
+  TSharedRef< FViconSubjectSchema, ESPMode::ThreadSafe > Schema = MakeShared< FViconSubjectSchema, ESPMode::ThreadSafe >();
+  const FViconNamePtr SubjectName = m_Names.FindOrAdd( i_SubjectName );
+  const std::string& SubjectNameUtf8 = SubjectName->Utf8();
 
-      // markers
-      if (m_DataStream.GetMarkerNamesForSubject(TCHAR_TO_UTF8(*i_rSubjectName), o_rMarkerNames) != ESuccess)
-      {
-        UE_LOG( LogViconStream, Error, TEXT( "Failed to get marker names for &s" ), *i_rSubjectName );
-        return false;
-      }
-      StaticTransformData.PropertyNames = MarkerPropertiesFromNames(o_rMarkerNames);
+  unsigned int numBone = 0;
+  if( m_DataStream.GetSegmentCountForSubject( SubjectNameUtf8, numBone ) != ESuccess )
+  {
+    UE_LOG( LogViconStream, Error, TEXT( "Failed to get source skeleton segment count from Vicon Stream" ) );
+    return false;
+  }
+  const int32 NumBoneDefs = static_cast< int32 >( numBone );
 
-      // skeleton segment
-      o_rSubjectBones.Empty();
-      FString Name;
-      if( m_DataStream.GetSegmentNameForSubject( TCHAR_TO_UTF8( *i_rSubjectName ), 0, Name ) != ESuccess )
-      {
-        UE_LOG( LogViconStream, Error, TEXT( "Failed to get source skeleton segment name" ) );
-        return false;
-      }
-      // push data
-      if( !m_bStopTask )
-      {
-        m_pLiveLinkClient->PushSubjectStaticData_AnyThread( {m_SourceGuid, SubjectNameFName}, ULiveLinkTransformRole::StaticClass(), MoveTemp( StaticDataStruct ) );
-      }
+  // marker names
+  TArray< FViconNameId > MarkerNames;
+  if( m_DataStream.GetMarkerNamesForSubject( SubjectNameUtf8, MarkerNames ) != ESuccess )
+  {
+    UE_LOG( LogViconStream, Error, TEXT( "Failed to get marker names for %s" ), *SubjectName->Name() );
+    return false;
+  }
 
-      o_rSubjectBones.Emplace( TCHAR_TO_UTF8( *Name ) );
-      return true;
+  // Bones are kept as pooled names rather than FName, as conversion to FName loses case sensitivity
+  const FViconNamePool& rPool = FViconNamePool::Get();
+  TArray< FViconNameId > SubjectBones;
+  SubjectBones.Reserve( NumBoneDefs );
+  TMap< FViconNameId, int32 > BoneIndices;
+  BoneIndices.Reserve( NumBoneDefs );
+  for( int32 i = 0; i < NumBoneDefs; ++i )
+  {
+    FViconNameId Name;
+
+    if( m_DataStream.GetSegmentNameForSubject( SubjectNameUtf8, i, Name ) != ESuccess )
+    {
+      UE_LOG( LogViconStream, Error, TEXT( "Failed to get source skeleton segment name" ) );
+      return false;
     }
 
-    // subject
-    FLiveLinkStaticDataStruct StaticDataStruct = FLiveLinkStaticDataStruct( FLiveLinkSkeletonStaticData::StaticStruct() );
-    FLiveLinkSkeletonStaticData& StaticData = *StaticDataStruct.Cast< FLiveLinkSkeletonStaticData >();
+    SubjectBones.Add( Name );
+    BoneIndices.Add( Name, i );
+  }
 
-    NumBoneDefs = static_cast< int32 >( numBone );
+  // A rigid body has a single segment, with no parent
+  TArray< int32 > BoneParents;
+  BoneParents.Init( INDEX_NONE, NumBoneDefs );
+  for( int32 i = 0; NumBoneDefs > 1 && i < NumBoneDefs; ++i )
+  {
+    FViconNameId ParentName;
 
-    StaticData.BoneNames.SetNumUninitialized( NumBoneDefs );
-    StaticData.BoneParents.SetNumUninitialized( NumBoneDefs );
-    o_rSubjectBones.Empty();
-    
-    // marker names
-    if (m_DataStream.GetMarkerNamesForSubject(TCHAR_TO_UTF8(*i_rSubjectName), o_rMarkerNames) != ESuccess)
+    if( m_DataStream.GetSegmentParentNameForSubject( SubjectNameUtf8, rPool.GetUtf8( SubjectBones[ i ] ), ParentName ) != ESuccess )
     {
-      UE_LOG( LogViconStream, Error, TEXT( "Failed to get marker names for &s" ), *i_rSubjectName );
+      UE_LOG( LogViconStream, Error, TEXT( "Failed to get source skeleton segment's parent name" ) );
       return false;
     }
-    StaticData.PropertyNames = MarkerPropertiesFromNames(o_rMarkerNames);
 
-    // We will use a vector of strings to access the datastream, as conversion
-    // to FName loses case sensitivity
-    for( int32 i = 0; i < NumBoneDefs; ++i )
-    {
-      FString Name;
+    const int32* pParentIndex = BoneIndices.Find( ParentName );
+    BoneParents[ i ] = pParentIndex ? *pParentIndex : INDEX_NONE;
+  }
 
-      if( m_DataStream.GetSegmentNameForSubject( TCHAR_TO_UTF8( *i_rSubjectName ), i, Name ) != ESuccess )
-      {
-        UE_LOG( LogViconStream, Error, TEXT( "Failed to get source skeleton segment name" ) );
-        return false;
-      }
+  // The scales depend on the subject's calibration, so only the names and parents are shared with other subjects
+  m_DataStream.GetHierarchyScales( SubjectNameUtf8, SubjectBones, Schema->HierarchyScales );
+  m_DataStream.GetStaticScales( SubjectNameUtf8, SubjectBones, Schema->StaticScales );
+  Schema->Template = m_SkeletonTemplates.FindOrAdd( MoveTemp( SubjectBones ), MoveTemp( MarkerNames ), MoveTemp( BoneParents ) );
+  if( NumBoneDefs > 0 && Schema->Template->SolveOrder.Num() == 0 )
+  {
+    UE_LOG( LogViconStream, Warning, TEXT( "Segments of %s do not form a hierarchy, component space poses are not available" ), *SubjectName->Name() );
+  }
 
-      o_rSubjectBones.Emplace( TCHAR_TO_UTF8( *Name ) );
-      StaticData.BoneNames[ i ] = FName( *Name );
-    }
+  // push data
+  io_rFrame.StaticDataUpdates.Add( MakeSubjectStaticData( *SubjectName, *Schema ) );
+  if( m_bComponentSpacePosesApplied )
+  {
+    AddComponentSpaceStaticData( *SubjectName, *Schema, io_rFrame );
+  }
 
-    for( int32 i = 0; i < NumBoneDefs; ++i )
-    {
-      FString Name;
-      FString ParentName;
+  o_rCachedSubject.Name = SubjectName;
+  o_rCachedSubject.Schema = Schema;
+  return true;
+}
 
-      if( m_DataStream.GetSegmentParentNameForSubject( TCHAR_TO_UTF8( *i_rSubjectName ), o_rSubjectBones[ i ], ParentName ) )
-      {
-        UE_LOG( LogViconStream, Error, TEXT( "Failed to get source skeleton segment's parent name" ) );
-        return false;
-      }
+FViconStaticDataUpdate FViconStreamFrameReader::MakeSubjectStaticData( const FViconName& i_rName, const FViconSubjectSchema& i_rSchema )
+{
+  // The names were built once for the template, so this only copies them
+  const FViconSkeletonTemplate& rTemplate = *i_rSchema.Template;
+  FViconStaticDataUpdate Update;
+  Update.SubjectName = i_rName.LiveLinkName;
 
-      int32 ParentIndex = o_rSubjectBones.Find( TCHAR_TO_UTF8( *ParentName ) );
-      StaticData.BoneParents[ i ] = ParentIndex;
-    }
+  // rigid body
+  if( rTemplate.Bones.Num() == 1 )
+  {
+    Update.Role = ULiveLinkTransformRole::StaticClass();
+    Update.StaticData = FLiveLinkStaticDataStruct( FLiveLinkTransformStaticData::StaticStruct() );
+    FLiveLinkTransformStaticData& StaticTransformData = *Update.StaticData.Cast< FLiveLinkTransformStaticData >();
+    StaticTransformData.PropertyNames = rTemplate.PropertyNames;
+    return Update;
+  }
 
-    // push data
-    if( !m_bStopTask )
-    {
-      m_pLiveLinkClient->PushSubjectStaticData_AnyThread( 
-          {m_SourceGuid, SubjectNameFName}, ULiveLinkAnimationRole::StaticClass(), MoveTemp( StaticDataStruct ) );
-    }
+  // subject
+  Update.Role = ULiveLinkAnimationRole::StaticClass();
+  Update.StaticData = FLiveLinkStaticDataStruct( FLiveLinkSkeletonStaticData::StaticStruct() );
+  FLiveLinkSkeletonStaticData& StaticData = *Update.StaticData.Cast< FLiveLinkSkeletonStaticData >();
+  StaticData.BoneNames = rTemplate.BoneNames;
+  StaticData.BoneParents = rTemplate.BoneParents;
+  StaticData.PropertyNames = rTemplate.PropertyNames;
+  return Update;
+}
 
-    return true;
+void FViconStreamFrameReader::AddComponentSpaceStaticData( const FViconName& i_rName, const FViconSubjectSchema& i_rSchema, FViconRawFrame& io_rFrame )
+{
+  // Rigid bodies are already in component space, and a skeleton without a hierarchy has no component space poses
+  const FViconSkeletonTemplate& rTemplate = *i_rSchema.Template;
+  if( rTemplate.Bones.Num() <= 1 || rTemplate.SolveOrder.Num() == 0 )
+  {
+    return;
   }
 
-  return false;
+  FLiveLinkStaticDataStruct StaticDataStruct = FLiveLinkStaticDataStruct( FLiveLinkSkeletonStaticData::StaticStruct() );
+  FLiveLinkSkeletonStaticData& StaticData = *StaticDataStruct.Cast< FLiveLinkSkeletonStaticData >();
+  StaticData.BoneNames = rTemplate.BoneNames;
+  // Every pose is relative to the subject, so none of the bones has a parent
+  StaticData.BoneParents.Init( INDEX_NONE, rTemplate.Bones.Num() );
+  io_rFrame.StaticDataUpdates.Add( {i_rName.ComponentSpaceName, ULiveLinkAnimationRole::StaticClass(), MoveTemp( StaticDataStruct )} );
+}
+
+void FViconStreamFrameReader::UpdateComponentSpaceSubjects( FViconRawFrame& io_rFrame )
+{
+  const bool bComponentSpacePoses = m_bComponentSpacePoses;
+  if( bComponentSpacePoses != m_bComponentSpacePosesApplied )
+  {
+    m_bComponentSpacePosesApplied = bComponentSpacePoses;
+    for( const auto& rCachedSubject : m_CachedSubjects )
+    {
+      const FCachedSubject& rSubject = rCachedSubject.Value;
+      if( bComponentSpacePoses )
+      {
+        AddComponentSpaceStaticData( *rSubject.Name, *rSubject.Schema, io_rFrame );
+      }
+      else if( rSubject.Schema->Template->Bones.Num() > 1 )
+      {
+        io_rFrame.RemovedSubjects.Add( rSubject.Name->ComponentSpaceName );
+      }
+    }
+  }
+  io_rFrame.bComponentSpacePoses = m_bComponentSpacePosesApplied;
 }
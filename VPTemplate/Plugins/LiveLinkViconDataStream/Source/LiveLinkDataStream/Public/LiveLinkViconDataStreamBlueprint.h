@@ -12,9 +12,37 @@
 
 
 struct FLiveLinkBasicBlueprintData;
+struct FLiveLinkViconPointCloudBlueprintData;
 
 DECLARE_LOG_CATEGORY_CLASS( LogViconDataStreamBlueprint, Display, All )
 
+// A marker found by the marker spatial queries
+USTRUCT( BlueprintType )
+struct LIVELINKDATASTREAM_API FViconMarkerQueryResult
+{
+  GENERATED_BODY()
+
+  // LabeledMarker or UnlabeledMarker subject of the marker
+  UPROPERTY( BlueprintReadOnly, Category = Vicon )
+  FName Subject;
+
+  // Index of the marker's point in the subject's point cloud
+  UPROPERTY( BlueprintReadOnly, Category = Vicon )
+  int32 PointIndex = INDEX_NONE;
+
+  // Persistent id of the marker if unlabeled markers are tracked, -1 otherwise
+  UPROPERTY( BlueprintReadOnly, Category = Vicon )
+  int32 Id = INDEX_NONE;
+
+  // Translation of the marker in cm
+  UPROPERTY( BlueprintReadOnly, Category = Vicon )
+  FVector Translation = FVector::ZeroVector;
+
+  // Distance from the query location, 0 for box queries
+  UPROPERTY( BlueprintReadOnly, Category = Vicon )
+  float Distance = 0.0f;
+};
+
 /**
  * 
  */
@@ -47,7 +75,8 @@ public:
   static bool GetMarkerTranslationByName(UPARAM(ref) FLiveLinkBasicBlueprintData& BasicData, FString MarkerName, FVector& Translation);
 
   /**
-   * Retrieves marker translations from the provided LiveLink Basic Blueprint data.
+   * Retrieves the marker translations of a subject from the provided LiveLink Basic Blueprint data.
+   * The LabeledMarker and UnlabeledMarker subjects use the point cloud role, see Get Point Cloud Translations.
    *
    * @param BasicData        Reference to FLiveLinkBasicBlueprintData containing marker information.
    * @param Translation      An array to store the retrieved marker translations.
@@ -60,4 +89,49 @@ public:
   UFUNCTION(BlueprintPure, Category = Vicon, meta = (DisplayName = "Get Marker Translations"))
   static bool GetMarkerTranslations(UPARAM(ref) FLiveLinkBasicBlueprintData& BasicData, TArray<FVector>& Translations);
 
+  /**
+   * Retrieves the translations of the markers in a LabeledMarker or UnlabeledMarker subject's point cloud.
+   *
+   * @param PointCloudData   Reference to FLiveLinkViconPointCloudBlueprintData containing the points.
+   * @param Translations     An array to store the translations of the valid points.
+   *                         In case of error, the array will be empty.
+   * @return                 True if the marker translations were successfully retrieved, false otherwise.
+   */
+  UFUNCTION(BlueprintPure, Category = Vicon, meta = (DisplayName = "Get Point Cloud Translations"))
+  static bool GetPointCloudTranslations(UPARAM(ref) FLiveLinkViconPointCloudBlueprintData& PointCloudData, TArray<FVector>& Translations);
+
+  /**
+   * Finds the labeled or unlabeled marker nearest to a location, in the latest frame of every Vicon source.
+   * Uses the marker index published by sources with the Publish Marker Index setting enabled.
+   * Locations are in the LiveLink space of the marker subjects, in cm.
+   *
+   * @param Location         Location to search from.
+   * @param MaxDistance      Furthest the marker may be from Location, or 0 for no limit.
+   * @param Marker           The nearest marker, if one was found.
+   * @return                 True if a marker was found within MaxDistance.
+   */
+  UFUNCTION(BlueprintCallable, Category = Vicon, meta = (DisplayName = "Find Nearest Marker"))
+  static bool FindNearestMarker(FVector Location, float MaxDistance, FViconMarkerQueryResult& Marker);
+
+  /**
+   * Finds the labeled and unlabeled markers within a radius of a location, in the latest frame of every Vicon source.
+   *
+   * @param Location         Centre of the sphere to search, in cm.
+   * @param Radius           Radius of the sphere to search, in cm.
+   * @param Markers          The markers found, nearest first.
+   * @return                 True if any marker was found.
+   */
+  UFUNCTION(BlueprintCallable, Category = Vicon, meta = (DisplayName = "Find Markers In Radius"))
+  static bool FindMarkersInRadius(FVector Location, float Radius, TArray<FViconMarkerQueryResult>& Markers);
+
+  /**
+   * Finds the labeled and unlabeled markers inside a box, in the latest frame of every Vicon source.
+   *
+   * @param Box              Axis aligned box to search, in cm.
+   * @param Markers          The markers found, in no particular order.
+   * @return                 True if any marker was found.
+   */
+  UFUNCTION(BlueprintCallable, Category = Vicon, meta = (DisplayName = "Find Markers In Box"))
+  static bool FindMarkersInBox(FBox Box, TArray<FViconMarkerQueryResult>& Markers);
+
 };
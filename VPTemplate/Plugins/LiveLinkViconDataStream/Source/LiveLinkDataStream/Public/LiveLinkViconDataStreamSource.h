@@ -5,6 +5,8 @@
 //
 // Utilises a helper stream reader class which runs on a worker thread
 // receiving data from Vicon and pushing through to the LiveLink client.
+// A source may stream from several Vicon systems at once, with one reader
+// per system. Subjects of each system are named with the system's prefix.
 // =========================================================================
 #pragma once
 
@@ -41,6 +43,11 @@ public:
   bool IsConnected() const;
 
 private:
+  // Apply the source settings to every reader
+  void ApplySettings( ULiveLinkSourceSettings* Settings );
+  // Whether every system is connected and its last frame had a timecode
+  bool AllSystemsHaveTimecode() const;
+
   ILiveLinkClient* Client;
 
   // Our identifier in LiveLink
@@ -49,5 +56,6 @@ private:
   FText SourceType;
 
   ViconStreamProperties ViconStreamProps;
-  FViconStreamFrameReader* ViconStreamFrameReader;
+  // One reader per system, the primary system first
+  TArray< FViconStreamFrameReader* > ViconStreamFrameReaders;
 };
@@ -6,6 +6,17 @@
 #include "LiveLinkSourceSettings.h"
 #include "LiveLinkViconDataStreamSourceSettings.generated.h"
 
+// Scheduling priority of the frame reader threads
+UENUM()
+enum class EViconReaderThreadPriority : uint8
+{
+  BelowNormal,
+  Normal,
+  AboveNormal,
+  Highest,
+  TimeCritical,
+};
+
 UCLASS()
 class LIVELINKDATASTREAM_API ULiveLinkDataStreamSourceSettings : public ULiveLinkSourceSettings
 {
@@ -18,6 +29,18 @@ public:
     StreamMarkerData = false;
     StreamUnlabeledMarkerData = false;
     ShowAllVideoCamera = false;
+    EventDrivenFrameWait = false;
+    FrameWaitTimeoutMs = 10;
+    LatestFrameOnly = false;
+    PublishComponentSpacePoses = false;
+    TrackUnlabeledMarkers = false;
+    UnlabeledMarkerGateDistance = 5.0f;
+    PublishMarkerIndex = false;
+    ReaderThreadPriority = EViconReaderThreadPriority::BelowNormal;
+    ReaderAffinityMask = 0;
+    ReaderDedicatedCore = -1;
+    SubjectConversionWorkers = 0;
+    AlignSystemsByTimecode = false;
   };
   UPROPERTY( EditAnywhere, Category = DataStreamSettings )
   bool EnableLightweight;
@@ -30,4 +53,62 @@ public:
 
   UPROPERTY( EditAnywhere, Category = DataStreamSettings, AdvancedDisplay )
   bool ShowAllVideoCamera;
+
+  // Block in the DataStream SDK until the server pushes a new frame rather than polling for it.
+  // This only sets the stream mode to ServerPush; when disabled, the reader polls for a new frame every 1 ms.
+  UPROPERTY( EditAnywhere, Category = DataStreamSettings, AdvancedDisplay )
+  bool EventDrivenFrameWait;
+
+  // Longest time the reader waits before asking the SDK again when GetFrame fails in ServerPush, e.g. because
+  // the connection dropped, and the conversion thread waits for a frame before checking its settings again
+  UPROPERTY( EditAnywhere, Category = DataStreamSettings, AdvancedDisplay, meta = ( EditCondition = "EventDrivenFrameWait", ClampMin = "1", ClampMax = "1000", Units = "ms" ) )
+  int32 FrameWaitTimeoutMs;
+
+  // Only convert the newest frame available. Frames which are superseded before they are converted,
+  // e.g. during a game thread hitch, are skipped rather than pushed to LiveLink late.
+  UPROPERTY( EditAnywhere, Category = DataStreamSettings, AdvancedDisplay )
+  bool LatestFrameOnly;
+
+  // Also publish the pose of every skeleton segment relative to the subject, as a subject named
+  // <Subject>_ComponentSpace, so that consumers do not have to walk the hierarchy themselves.
+  UPROPERTY( EditAnywhere, Category = DataStreamSettings, AdvancedDisplay )
+  bool PublishComponentSpacePoses;
+
+  // Give unlabeled markers ids which persist from frame to frame, published with their positions,
+  // so that consumers do not have to work out which marker is which themselves.
+  UPROPERTY( EditAnywhere, Category = DataStreamSettings, AdvancedDisplay )
+  bool TrackUnlabeledMarkers;
+
+  // Furthest an unlabeled marker may be from where it was predicted to be and keep its id
+  UPROPERTY( EditAnywhere, Category = DataStreamSettings, AdvancedDisplay, meta = ( EditCondition = "TrackUnlabeledMarkers", ClampMin = "0.1", ClampMax = "100.0", Units = "cm" ) )
+  float UnlabeledMarkerGateDistance;
+
+  // Build a spatial index of the labeled and unlabeled markers of each frame, for the Find Nearest Marker,
+  // Find Markers In Radius and Find Markers In Box Blueprint functions. Off by default, as building it costs
+  // every frame whether or not anything queries it.
+  UPROPERTY( EditAnywhere, Category = DataStreamSettings, AdvancedDisplay )
+  bool PublishMarkerIndex;
+
+  // Priority of the threads receiving and converting frames
+  UPROPERTY( EditAnywhere, Category = "DataStreamSettings|Scheduling", AdvancedDisplay )
+  EViconReaderThreadPriority ReaderThreadPriority;
+
+  // Logical cores the reader threads may run on, one bit per core. 0 lets the OS choose.
+  UPROPERTY( EditAnywhere, Category = "DataStreamSettings|Scheduling", AdvancedDisplay, meta = ( ClampMin = "0" ) )
+  int64 ReaderAffinityMask;
+
+  // Pin the thread receiving frames to this logical core, and keep the conversion thread off it. -1 to disable.
+  UPROPERTY( EditAnywhere, Category = "DataStreamSettings|Scheduling", AdvancedDisplay, meta = ( ClampMin = "-1", ClampMax = "63" ) )
+  int32 ReaderDedicatedCore;
+
+  // Convert subjects in parallel on up to this many task graph workers. Frame data is still pushed to LiveLink in
+  // subject order. 0 converts all subjects on the reader's conversion thread.
+  UPROPERTY( EditAnywhere, Category = "DataStreamSettings|Scheduling", AdvancedDisplay, meta = ( ClampMin = "0", ClampMax = "64" ) )
+  int32 SubjectConversionWorkers;
+
+  // When the source streams from more than one Vicon system, evaluate its subjects by timecode so that
+  // subjects from all systems are evaluated at the same point in time. The systems must share a timecode source:
+  // frames without a timecode can't be evaluated in timecode mode, so this is only applied once every system reports one.
+  UPROPERTY( EditAnywhere, Category = DataStreamSettings, AdvancedDisplay )
+  bool AlignSystemsByTimecode;
 };
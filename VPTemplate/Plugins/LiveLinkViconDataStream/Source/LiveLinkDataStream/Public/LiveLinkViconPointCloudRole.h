@@ -0,0 +1,89 @@
+// Copyright (c) 2021 Vicon Motion Systems Ltd. All Rights Reserved.
+
+#pragma once
+
+// =========================================================================
+// LiveLink role of the LabeledMarker and UnlabeledMarker subjects.
+//
+// The markers of a frame are a contiguous array of points, with a validity
+// mask, rather than named float properties. Markers are only named when
+// they belong to a Vicon subject, so the static data carries no per marker
+// names: its size, and the cost of updating it, do not grow with the marker
+// count. Consumers read the points directly instead of unpacking floats.
+//
+// The role derives from the basic role, so the subjects can still be
+// evaluated as basic subjects, but they have no basic properties: the
+// marker count is MarkerCount of the frame data.
+// =========================================================================
+
+#include "CoreMinimal.h"
+#include "LiveLinkTypes.h"
+#include "Roles/LiveLinkBasicRole.h"
+#include "Roles/LiveLinkBasicTypes.h"
+
+#include "LiveLinkViconPointCloudRole.generated.h"
+
+USTRUCT( BlueprintType )
+struct LIVELINKDATASTREAM_API FLiveLinkViconPointCloudStaticData : public FLiveLinkBaseStaticData
+{
+  GENERATED_BODY()
+
+public:
+  // Number of points in every frame of the subject. Only the valid ones hold a marker.
+  UPROPERTY( VisibleAnywhere, BlueprintReadOnly, Category = "LiveLink" )
+  int32 Capacity = 0;
+};
+
+USTRUCT( BlueprintType )
+struct LIVELINKDATASTREAM_API FLiveLinkViconPointCloudFrameData : public FLiveLinkBaseFrameData
+{
+  GENERATED_BODY()
+
+public:
+  // Marker translations in cm, Capacity of them
+  UPROPERTY( VisibleAnywhere, Category = "LiveLink" )
+  TArray< FVector3f > Points;
+
+  // Whether each point holds a marker in this frame
+  UPROPERTY( VisibleAnywhere, BlueprintReadOnly, Category = "LiveLink" )
+  TArray< bool > Valid;
+
+  // Number of valid points
+  UPROPERTY( VisibleAnywhere, BlueprintReadOnly, Category = "LiveLink" )
+  int32 MarkerCount = 0;
+
+  // Id of the marker at each point, which persists from frame to frame, or INDEX_NONE for invalid points.
+  // Empty unless the source tracks unlabeled markers.
+  UPROPERTY( VisibleAnywhere, BlueprintReadOnly, Category = "LiveLink" )
+  TArray< int32 > Ids;
+};
+
+USTRUCT( BlueprintType )
+struct LIVELINKDATASTREAM_API FLiveLinkViconPointCloudBlueprintData : public FLiveLinkBaseBlueprintData
+{
+  GENERATED_BODY()
+
+public:
+  UPROPERTY( EditAnywhere, BlueprintReadWrite, Category = "LiveLink" )
+  FLiveLinkViconPointCloudStaticData StaticData;
+
+  UPROPERTY( EditAnywhere, BlueprintReadWrite, Category = "LiveLink" )
+  FLiveLinkViconPointCloudFrameData FrameData;
+};
+
+UCLASS( BlueprintType, meta = ( DisplayName = "Vicon Point Cloud Role" ) )
+class LIVELINKDATASTREAM_API ULiveLinkViconPointCloudRole : public ULiveLinkBasicRole
+{
+  GENERATED_BODY()
+
+public:
+  //~ Begin ULiveLinkRole interface
+  virtual UScriptStruct* GetStaticDataStruct() const override;
+  virtual UScriptStruct* GetFrameDataStruct() const override;
+  virtual UScriptStruct* GetBlueprintDataStruct() const override;
+  virtual bool InitializeBlueprintData( const FLiveLinkSubjectFrameData& InSourceData, FLiveLinkBlueprintDataStruct& OutBlueprintData ) const override;
+  virtual FText GetDisplayName() const override;
+  virtual bool IsStaticDataValid( const FLiveLinkStaticDataStruct& InStaticData, bool& bOutShouldLogWarning ) const override;
+  virtual bool IsFrameDataValid( const FLiveLinkStaticDataStruct& InStaticData, const FLiveLinkFrameDataStruct& InFrameData, bool& bOutShouldLogWarning ) const override;
+  //~ End ULiveLinkRole interface
+};
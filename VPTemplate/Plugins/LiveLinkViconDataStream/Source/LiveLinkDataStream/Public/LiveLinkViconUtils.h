@@ -3,12 +3,17 @@
 #include "Containers/Array.h"
 #include "Math/Vector.h"
 
+struct FLiveLinkViconPointCloudFrameData;
+
 DECLARE_LOG_CATEGORY_CLASS( LogLiveLinkViconUtils, Display, All )
 
 namespace LiveLinkViconUtils
 {
 
-// Get 3D points from marker subject frame data
+// Get 3D points from the marker properties of subject frame data
 bool GetMarkerTranslations(const TArray<float>& PropertyValues, TArray<FVector>& MarkerData);
 
+// Get the valid 3D points of LabeledMarker / UnlabeledMarker point cloud frame data
+bool GetMarkerTranslations(const FLiveLinkViconPointCloudFrameData& PointCloud, TArray<FVector>& MarkerData);
+
 }
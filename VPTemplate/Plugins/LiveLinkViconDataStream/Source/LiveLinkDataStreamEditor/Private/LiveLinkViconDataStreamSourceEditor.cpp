@@ -17,10 +17,11 @@ void SLiveLinkViconDataStreamSourceEditor::Construct( const FArguments& Args )
 
   PortNumber = 801;
   Offset = 0.0f;
+  ProbeTimeoutMs = 500;
 
   ChildSlot
     [ SNew( SBox )
-    .HeightOverride(215)
+    .HeightOverride(319)
         .WidthOverride( 250 )
           [ SNew( SVerticalBox ) + SVerticalBox::Slot().AutoHeight().Padding( 2.0f )[ SNew( SHorizontalBox ) + SHorizontalBox::Slot().HAlign( HAlign_Left ).FillWidth( 0.5f )[ SNew( STextBlock ).Text( LOCTEXT( "ViconServerName", "Vicon Server Name" ) ) ] + SHorizontalBox::Slot().HAlign( HAlign_Fill ).FillWidth( 0.5f )[ SAssignNew( ServerName, SEditableTextBox ).Text( LOCTEXT( "UndeterminedViconServerName", "localhost" ) ) ] ] + SVerticalBox::Slot().AutoHeight().Padding( 2.0f )[ SNew( SHorizontalBox ) + SHorizontalBox::Slot().HAlign( HAlign_Left ).FillWidth( 0.5f )[ SNew( STextBlock ).Text( LOCTEXT( "ViconPortNumber", "Port Number" ) ) ] + SHorizontalBox::Slot().HAlign( HAlign_Fill ).FillWidth( 0.5f )[ SNew( SNumericEntryBox< uint32 > ).Value( this, &SLiveLinkViconDataStreamSourceEditor::OnGet_PortNumber_EntryBoxValue ).OnValueChanged( this, &SLiveLinkViconDataStreamSourceEditor::On_PortNumber_EntryBoxChanged ) ] ] + SVerticalBox::Slot().AutoHeight().Padding( 8.0f, 4.0f, 8.0f, 4.0f )[ SNew( SSeparator ) ] + SVerticalBox::Slot().AutoHeight().Padding( 2.0f )[ SNew( SHorizontalBox ) + SHorizontalBox::Slot().HAlign( HAlign_Left ).FillWidth( 0.5f )[ SNew( STextBlock ).Text( LOCTEXT( "UsePreFetch", "Use PreFetch" ) ) ] + SHorizontalBox::Slot().HAlign( HAlign_Left ).FillWidth( 0.5f )[ SAssignNew( UsePreFetch, SCheckBox ).IsChecked( ECheckBoxState::Unchecked ) ] ] + SVerticalBox::Slot().AutoHeight().Padding( 2.0f )[ SNew( SHorizontalBox ) + SHorizontalBox::Slot().HAlign( HAlign_Left ).FillWidth( 0.5f )[ SNew( STextBlock ).Text( LOCTEXT( "IsRetimed", "Is Retimed" ) ) ] + SHorizontalBox::Slot().HAlign( HAlign_Left ).FillWidth( 0.5f )[ SAssignNew( IsRetimed, SCheckBox ).IsChecked( ECheckBoxState::Unchecked ) ] ] + SVerticalBox::Slot().AutoHeight().Padding( 2.0f )[ SNew( SHorizontalBox ) + SHorizontalBox::Slot().HAlign( HAlign_Left ).FillWidth( 0.1f )[ SNew( SBox ) ] + SHorizontalBox::Slot().HAlign( HAlign_Left ).FillWidth( 0.4f )[ SNew( STextBlock ).Text( LOCTEXT( "Offset", "Offset" ) ) ] + SHorizontalBox::Slot().HAlign( HAlign_Fill ).FillWidth( 0.5f )[ SNew( SNumericEntryBox< float > ).Value( this, &SLiveLinkViconDataStreamSourceEditor::OnGet_Offset_EntryBoxValue ).OnValueChanged( this, &SLiveLinkViconDataStreamSourceEditor::On_Offset_EntryBoxChanged ) ] ] + SVerticalBox::Slot().AutoHeight().Padding( 2.0f )
 
@@ -29,6 +30,26 @@ void SLiveLinkViconDataStreamSourceEditor::Construct( const FArguments& Args )
               .AutoHeight()
               .Padding( 2.0f )
                 [ SNew( SHorizontalBox ) + SHorizontalBox::Slot().HAlign( HAlign_Left ).FillWidth( 0.5f )[ SNew( STextBlock ).Text( LOCTEXT( "Subject Filter", "Subject Filter" ) ) ] + SHorizontalBox::Slot().HAlign( HAlign_Fill ).FillWidth( 0.5f )[ SAssignNew( SubjectFilter, SEditableTextBox ).Text( LOCTEXT( "EmptyFilter", "" ) ) ] ] +
+            SVerticalBox::Slot()
+              .AutoHeight()
+              .Padding( 2.0f )
+                [ SNew( SHorizontalBox ) + SHorizontalBox::Slot().HAlign( HAlign_Left ).FillWidth( 0.5f )[ SNew( STextBlock ).Text( LOCTEXT( "ParallelConnect", "Parallel Connect" ) ).ToolTipText( LOCTEXT( "ParallelConnectToolTip", "Try every server in a semi-colon separated list at once and use the first one to deliver a frame" ) ) ] + SHorizontalBox::Slot().HAlign( HAlign_Left ).FillWidth( 0.5f )[ SAssignNew( ParallelConnect, SCheckBox ).IsChecked( ECheckBoxState::Unchecked ) ] ] +
+            SVerticalBox::Slot()
+              .AutoHeight()
+              .Padding( 2.0f )
+                [ SNew( SHorizontalBox ) + SHorizontalBox::Slot().HAlign( HAlign_Left ).FillWidth( 0.1f )[ SNew( SBox ) ] + SHorizontalBox::Slot().HAlign( HAlign_Left ).FillWidth( 0.4f )[ SNew( STextBlock ).Text( LOCTEXT( "ProbeTimeout", "Probe Timeout (ms)" ) ) ] + SHorizontalBox::Slot().HAlign( HAlign_Fill ).FillWidth( 0.5f )[ SNew( SNumericEntryBox< uint32 > ).MinValue( ViconStreamProperties::MIN_PROBE_TIMEOUT_MS ).Value( this, &SLiveLinkViconDataStreamSourceEditor::OnGet_ProbeTimeout_EntryBoxValue ).OnValueChanged( this, &SLiveLinkViconDataStreamSourceEditor::On_ProbeTimeout_EntryBoxChanged ) ] ] +
+            SVerticalBox::Slot()
+              .AutoHeight()
+              .Padding( 8.0f, 4.0f, 8.0f, 4.0f )
+                [ SNew( SSeparator ) ] +
+            SVerticalBox::Slot()
+              .AutoHeight()
+              .Padding( 2.0f )
+                [ SNew( SHorizontalBox ) + SHorizontalBox::Slot().HAlign( HAlign_Left ).FillWidth( 0.5f )[ SNew( STextBlock ).Text( LOCTEXT( "SubjectPrefix", "Subject Prefix" ) ) ] + SHorizontalBox::Slot().HAlign( HAlign_Fill ).FillWidth( 0.5f )[ SAssignNew( SubjectPrefix, SEditableTextBox ).Text( LOCTEXT( "EmptyPrefix", "" ) ) ] ] +
+            SVerticalBox::Slot()
+              .AutoHeight()
+              .Padding( 2.0f )
+                [ SNew( SHorizontalBox ) + SHorizontalBox::Slot().HAlign( HAlign_Left ).FillWidth( 0.5f )[ SNew( STextBlock ).Text( LOCTEXT( "AdditionalSystems", "Additional Systems" ) ).ToolTipText( LOCTEXT( "AdditionalSystemsToolTip", "Other Vicon systems to stream from in parallel, as a comma separated list of Prefix=Server[:Port]" ) ) ] + SHorizontalBox::Slot().HAlign( HAlign_Fill ).FillWidth( 0.5f )[ SAssignNew( AdditionalSystems, SEditableTextBox ).Text( LOCTEXT( "EmptyAdditionalSystems", "" ) ) ] ] +
             SVerticalBox::Slot()
               .AutoHeight()
               .Padding( 2.0f )
@@ -42,11 +63,15 @@ FReply SLiveLinkViconDataStreamSourceEditor::CreateSource() const
   ViconStreamProperties Properties;
   Properties.m_ServerName = GetServerName();
   Properties.m_SubjectFilter = GetSubjectFilter();
+  Properties.m_SubjectPrefix = GetSubjectPrefix();
+  Properties.m_AdditionalSystems = GetAdditionalSystems();
   Properties.m_PortNumber = GetPortNumber();
   Properties.m_bRetimed = GetIsRetimed();
   Properties.m_bLogOutput = GetLogOutput();
   Properties.m_bUsePrefetch = GetUsePrefetch();
   Properties.m_RetimeOffset = GetOffset();
+  Properties.m_bParallelConnect = GetParallelConnect();
+  Properties.m_ProbeTimeoutMs = GetProbeTimeout();
 
   Properties.m_bScaled = true;
 
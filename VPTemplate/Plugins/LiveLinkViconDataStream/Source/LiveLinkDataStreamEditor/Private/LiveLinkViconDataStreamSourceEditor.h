@@ -34,20 +34,27 @@ class SLiveLinkViconDataStreamSourceEditor : public SCompoundWidget
 
   FText GetServerName() const { return ServerName.Get()->GetText(); }
   FText GetSubjectFilter() const { return SubjectFilter.Get()->GetText(); }
+  FText GetSubjectPrefix() const { return SubjectPrefix.Get()->GetText(); }
+  FText GetAdditionalSystems() const { return AdditionalSystems.Get()->GetText(); }
 
   uint32 GetPortNumber() const { return PortNumber.IsSet() ? PortNumber.GetValue() : 801; }
   bool GetIsRetimed() const { return IsRetimed->IsChecked(); }
   float GetOffset() const { return Offset.IsSet() ? Offset.GetValue() : 0.0f; }
   bool GetLogOutput() const { return LogOutput->IsChecked(); }
   bool GetUsePrefetch() const { return UsePreFetch->IsChecked(); }
+  bool GetParallelConnect() const { return ParallelConnect->IsChecked(); }
+  uint32 GetProbeTimeout() const { return ProbeTimeoutMs.IsSet() ? ProbeTimeoutMs.GetValue() : 500; }
 
 private:
   TSharedPtr< SEditableTextBox > ServerName;
   TSharedPtr< SEditableTextBox > SubjectFilter;
+  TSharedPtr< SEditableTextBox > SubjectPrefix;
+  TSharedPtr< SEditableTextBox > AdditionalSystems;
   TSharedPtr< SCheckBox > IsStreamYUp;
   TSharedPtr< SCheckBox > IsRetimed;
   TSharedPtr< SCheckBox > LogOutput;
   TSharedPtr< SCheckBox > UsePreFetch;
+  TSharedPtr< SCheckBox > ParallelConnect;
 
   TOptional< uint32 > PortNumber;
   void On_PortNumber_EntryBoxChanged( uint32 NewValue )
@@ -71,6 +78,17 @@ private:
     return Offset;
   }
 
+  TOptional< uint32 > ProbeTimeoutMs;
+  void On_ProbeTimeout_EntryBoxChanged( uint32 NewValue )
+  {
+    ProbeTimeoutMs = FMath::Max( NewValue, ViconStreamProperties::MIN_PROBE_TIMEOUT_MS );
+  }
+
+  TOptional< uint32 > OnGet_ProbeTimeout_EntryBoxValue() const
+  {
+    return ProbeTimeoutMs;
+  }
+
   FReply CreateSource() const;
 
   FOnDataStreamPropertiesSelected OnPropertiesSelected;